@@ -25,8 +25,14 @@
 #include <string.h>
 #include <stdio.h>
 #include <algorithm>
+#include <errno.h>
+#include <ctype.h>
+#include <thread>
+#include <atomic>
+#include <exception>
 
 const int args_parser::version = 1;
+const int args_parser::hash_version = 2;
 
 args_parser::value &args_parser::value::operator=(const args_parser::value &other) {
     assert(other.initialized);
@@ -39,6 +45,8 @@ args_parser::value &args_parser::value::operator=(const args_parser::value &othe
         case INT: i = other.i; break;
         case FLOAT: f = other.f; break;
         case BOOL: b = other.b; break;
+        case INT64: i64 = other.i64; break;
+        case DOUBLE: d = other.d; break;
         default: assert(NULL == "Impossible case in switch(type)");
     }
     initialized = true;
@@ -46,9 +54,55 @@ args_parser::value &args_parser::value::operator=(const args_parser::value &othe
 }
 
 args_parser::value::value(const args_parser::value &other) {
+    // copies of option_state carry unset values as well
+    if (!other.initialized) {
+        type = other.type;
+        return;
+    }
     *this = other;
 }
 
+bool args_parser::value::operator==(const args_parser::value &other) const {
+    if (initialized != other.initialized)
+        return false;
+    if (!initialized)
+        return true;
+    if (type != other.type)
+        return false;
+    switch (type) {
+        case STRING: return str == other.str;
+        case INT: return i == other.i;
+        case FLOAT: return f == other.f;
+        case BOOL: return b == other.b;
+        case INT64: return i64 == other.i64;
+        case DOUBLE: return d == other.d;
+        default: assert(NULL == "Impossible case in switch(type)");
+    }
+    return false;
+}
+
+static bool parse_int64(const char *sval, int64_t &result) {
+    static const struct { const char *suffix; int64_t multiplier; } suffixes[] = {
+        { "", 1 },
+        { "K", 1LL << 10 }, { "M", 1LL << 20 }, { "G", 1LL << 30 }, { "T", 1LL << 40 },
+        { "Ki", 1LL << 10 }, { "Mi", 1LL << 20 }, { "Gi", 1LL << 30 }, { "Ti", 1LL << 40 }
+    };
+    char *end = NULL;
+    errno = 0;
+    long long v = strtoll(sval, &end, 10);
+    if (end == sval || errno == ERANGE)
+        return false;
+    for (auto &s : suffixes) {
+        if (strcmp(end, s.suffix))
+            continue;
+        if (v > INT64_MAX / s.multiplier || v < INT64_MIN / s.multiplier)
+            return false;
+        result = (int64_t)v * s.multiplier;
+        return true;
+    }
+    return false;
+}
+
 bool args_parser::value::parse(const char *sval, arg_t _type) {
     type = _type;
     int res = 0;
@@ -56,6 +110,8 @@ bool args_parser::value::parse(const char *sval, arg_t _type) {
         case STRING: str.assign(sval); res = 1; break;
         case INT: res = sscanf(sval, "%d", &i); break;
         case FLOAT: res = sscanf(sval, "%f", &f); break;
+        case INT64: res = parse_int64(sval, i64) ? 1 : 0; break;
+        case DOUBLE: res = sscanf(sval, "%lf", &d); break;
         case BOOL: { 
             res = 1;
             std::string s; s.assign(sval);
@@ -91,6 +147,8 @@ const std::string args_parser::value::get_type_str(arg_t _type) {
         case INT: return "INT";
         case FLOAT: return "FLOAT";
         case BOOL: return "BOOL";
+        case INT64: return "INT64";
+        case DOUBLE: return "DOUBLE";
         default: assert(NULL == "Impossible case in switch(type)");                    
     }
     return "";
@@ -105,6 +163,8 @@ YAML::Emitter &operator<< (YAML::Emitter& out, const args_parser::value &v) {
             case args_parser::INT: out << v.i; break;
             case args_parser::FLOAT: out << v.f; break;
             case args_parser::BOOL: out << v.b; break;
+            case args_parser::INT64: out << (long long)v.i64; break;
+            case args_parser::DOUBLE: out << v.d; break;
             default: assert(NULL == "Impossible case in switch(type)");
         }
     }
@@ -117,59 +177,58 @@ void operator>> (const YAML::Node& node, args_parser::value &v) {
         case args_parser::INT: v.i = node.as<int>(); break;
         case args_parser::FLOAT: v.f = node.as<float>(); break;
         case args_parser::BOOL: v.b = node.as<bool>(); break;
+        case args_parser::INT64: {
+            // suffixes are allowed in YAML input as well
+            if (!parse_int64(node.as<std::string>().c_str(), v.i64))
+                throw YAML::BadConversion(node.Mark());
+            break;
+        }
+        case args_parser::DOUBLE: v.d = node.as<double>(); break;
         default: assert(NULL == "Impossible case in switch(type)");
     }
     v.initialized = true;
 }
 
-YAML::Emitter &operator<< (YAML::Emitter& out, const args_parser::option &opt) {
-    opt.to_yaml(out);
-    return out;
-}
+void args_parser::option_scalar::to_yaml(YAML::Emitter& out, const option_state &st) const { out << st.val; }
+void args_parser::option_scalar::from_yaml(const YAML::Node& node, option_state &st) const { st.val.type = type; node >> st.val; }
 
-void operator>> (const YAML::Node& node, args_parser::option &opt) {
-    opt.from_yaml(node);
-    opt.defaulted = false;
-}
+void args_parser::option_vector::to_yaml(YAML::Emitter& out, const option_state &st) const { out << YAML::Flow << st.get_vals(); }
 
-void args_parser::option_scalar::to_yaml(YAML::Emitter& out) const { out << val; }
-void args_parser::option_scalar::from_yaml(const YAML::Node& node) { val.type = type; node >> val; }
-
-void args_parser::option_vector::to_yaml(YAML::Emitter& out) const { out << YAML::Flow << val; }
-
-void args_parser::option_vector::from_yaml(const YAML::Node& node) 
+void args_parser::option_vector::from_yaml(const YAML::Node& node, option_state &st) const
 {
     if (!node.IsSequence()) {
         throw yaml_error_t::NOT_SEQUENCE;
     }
-    if (!required && defaulted && !defaultize_before_parsing) {
-        val.resize(0);
+    std::vector<value> &vals = st.mutable_vals();
+    if (!required && st.defaulted && !defaultize_before_parsing) {
+        vals.resize(0);
     }
-    if (val.size() < node.size()) {
-        val.resize(node.size());
+    if (vals.size() < node.size()) {
+        vals.resize(node.size());
     }
     if (node.size() < (size_t)vec_min || node.size() > (size_t)vec_max) {
         throw yaml_error_t::INVALID_SIZE;
     }
     for (size_t i = 0; i < node.size(); i++) {
-        val[i].type = type;
-        node[i] >> val[i];
+        vals[i].type = type;
+        node[i] >> vals[i];
     }
 }
 
-void args_parser::option_map::to_yaml(YAML::Emitter& out) const { 
+void args_parser::option_map::to_yaml(YAML::Emitter& out, const option_state &st) const { 
     out << YAML::BeginMap << YAML::Flow;
-    for (auto it = kvmap.begin(); it != kvmap.end(); ++it) {
+    for (auto it = st.get_kvmap().begin(); it != st.get_kvmap().end(); ++it) {
         out << YAML::Key << it->first << YAML::Value << it->second;
     }
     out << YAML::EndMap;
 }
 
-void args_parser::option_map::from_yaml(const YAML::Node& node) 
+void args_parser::option_map::from_yaml(const YAML::Node& node, option_state &st) const
 {
     if (!node.IsMap()) {
         throw yaml_error_t::NOT_MAP;
     }
+    std::map<std::string, std::string> &kvmap = st.mutable_kvmap();
     for (auto it = node.begin(); it != node.end(); ++it) {
         std::string key, value;
         key = it->first.as<std::string>();
@@ -182,13 +241,13 @@ void args_parser::option_map::from_yaml(const YAML::Node& node)
 
 #endif
 
-bool args_parser::option_scalar::do_parse(const char *sval) {
-    if (val.initialized && parser.is_flag_set(NODUPLICATE))
+bool args_parser::option_scalar::do_parse(const args_parser &p, option_state &st, const char *sval) const {
+    if (st.val.initialized && p.is_flag_set(NODUPLICATE))
         return false;
-    return val.parse(sval, type); 
+    return st.val.parse(sval, type); 
 }
 
-bool args_parser::option_vector::do_parse(const char *const_sval) {
+bool args_parser::option_vector::do_parse(const args_parser &p, option_state &st, const char *const_sval) const {
     bool res = true;
     std::string sval(const_sval);
     std::vector<int> positions;
@@ -198,29 +257,42 @@ bool args_parser::option_vector::do_parse(const char *const_sval) {
     }
     positions.push_back(sval.size());
     size_t nelems = sval.size() ? positions.size() : 0;
-    size_t max_elem = num_already_initialized_elems + nelems;
+    size_t max_elem = st.num_already_initialized_elems + nelems;
     if (max_elem < (size_t)vec_min || max_elem > (size_t)vec_max) 
         return false;
-    val.resize(std::max(max_elem, val.size()));
+    std::vector<value> &vals = st.mutable_vals();
+    vals.resize(std::max(max_elem, vals.size()));
     if (nelems == 0) 
         return true;
     for (size_t i = 0, j = 0; i < positions.size(); i++) {
         sval[positions[i]] = 0;
-        int n = num_already_initialized_elems + i;
-        if (val[n].initialized && parser.is_flag_set(NODUPLICATE))
+        int n = st.num_already_initialized_elems + i;
+        if (vals[n].initialized && p.is_flag_set(NODUPLICATE))
             return false;
-        res = res && val[n].parse(sval.c_str() + j, type);
+        res = res && vals[n].parse(sval.c_str() + j, type);
         j = positions[i] + 1;
     }
-    num_already_initialized_elems += positions.size();
+    st.num_already_initialized_elems += positions.size();
     return res;
 }
 
-void args_parser::option_vector::set_default_value() {
-    if (num_already_initialized_elems == 0) {
-        do_parse(vec_def.c_str());
-        defaulted = true;
-        num_already_initialized_elems = 0;
+void args_parser::option_vector::prepare_defaults(const args_parser &p) {
+    option_state st;
+    if (!do_parse(p, st, vec_def.c_str()))
+        throw std::logic_error("args_parser: can't parse the default value of option: " + str);
+    def_vals = std::make_shared<const std::vector<value>>(std::move(st.vals));
+}
+
+void args_parser::option_vector::set_default_value(const args_parser &p, option_state &st) const {
+    if (st.num_already_initialized_elems == 0) {
+        // the pre-parsed defaults are shared until the first change, the values
+        // partially set by a failed parse are overwritten as before
+        if (def_vals && st.get_vals().empty())
+            st.shared_vals = def_vals;
+        else
+            do_parse(p, st, vec_def.c_str());
+        st.defaulted = true;
+        st.num_already_initialized_elems = 0;
     }
 }
 
@@ -237,7 +309,7 @@ static void str_split(const std::string& s, char delimiter, std::vector<std::str
 }
 
 
-bool args_parser::option_map::do_parse(const char *const_sval) {
+bool args_parser::option_map::do_parse(const args_parser &p, option_state &st, const char *const_sval) const {
     bool res = true;
     std::string sval(const_sval);
     std::vector<int> positions;
@@ -247,23 +319,24 @@ bool args_parser::option_map::do_parse(const char *const_sval) {
     }
     positions.push_back(sval.size());
     size_t nelems = sval.size() ? positions.size() : 0;
-    size_t max_elem = num_already_initialized_elems + nelems;
-    val.resize(std::max(max_elem, val.size()));
+    size_t max_elem = st.num_already_initialized_elems + nelems;
+    std::vector<value> &vals = st.mutable_vals();
+    vals.resize(std::max(max_elem, vals.size()));
     if (nelems == 0) 
         return true;
     for (size_t i = 0, j = 0; i < positions.size(); i++) {
         sval[positions[i]] = 0;
-        int n = num_already_initialized_elems + i;
-        if (val[n].initialized && parser.is_flag_set(NODUPLICATE))
+        int n = st.num_already_initialized_elems + i;
+        if (vals[n].initialized && p.is_flag_set(NODUPLICATE))
             return false;
-        res = res && val[n].parse(sval.c_str() + j, type);
+        res = res && vals[n].parse(sval.c_str() + j, type);
         j = positions[i] + 1;
     }
     if (!res)
         return false;
-    num_already_initialized_elems += positions.size();
+    st.num_already_initialized_elems += positions.size();
     std::map<std::string, std::string> kvmap_local;
-    for (auto v : val) {
+    for (auto v : vals) {
         std::vector<std::string> kv;
         str_split(v.str, kv_delimiter, kv);
         if (kv.size() != 2)
@@ -275,29 +348,46 @@ bool args_parser::option_map::do_parse(const char *const_sval) {
             kvmap_local[kv[0]] = oldval + ";" + kv[1];
         }
     }
+    std::map<std::string, std::string> &kvmap = st.mutable_kvmap();
     for (auto kv : kvmap_local) {
         auto key = kv.first;
         auto value = kv.second;
-		if (kvmap.find(key) == kvmap.end() || map_always_override) {
+		if (kvmap.find(key) == kvmap.end() || st.map_always_override) {
 			kvmap[key] = value;
 		} else {
 			auto oldval = kvmap[key];
 			kvmap_local[key] = oldval + ";" + value;
 		}
     }
-	map_always_override = false;
+	st.map_always_override = false;
     return true;
 }
 
-void args_parser::option_map::set_default_value() {
-    if (num_already_initialized_elems == 0) {
+void args_parser::option_map::prepare_defaults(const args_parser &p) {
+    if (vec_def == "")
+        return;
+    option_state st;
+    st.map_always_override = true;
+    if (!do_parse(p, st, vec_def.c_str()))
+        throw std::logic_error("args_parser: can't parse the default value of option: " + str);
+    def_vals = std::make_shared<const std::vector<value>>(std::move(st.vals));
+    def_kvmap = std::make_shared<const std::map<std::string, std::string>>(std::move(st.kvmap));
+}
+
+void args_parser::option_map::set_default_value(const args_parser &p, option_state &st) const {
+    if (st.num_already_initialized_elems == 0) {
         if (vec_def != "") {
-            map_always_override = true;
-            do_parse(vec_def.c_str());
-            map_always_override = true;
+            if (def_vals && st.get_vals().empty() && st.get_kvmap().empty()) {
+                st.shared_vals = def_vals;
+                st.shared_kvmap = def_kvmap;
+            } else {
+                st.map_always_override = true;
+                do_parse(p, st, vec_def.c_str());
+            }
+            st.map_always_override = true;
         }
-        defaulted = true;
-        num_already_initialized_elems = 0;
+        st.defaulted = true;
+        st.num_already_initialized_elems = 0;
     }
 }
 
@@ -308,14 +398,37 @@ args_parser::option &args_parser::add_flag(const char *s) {
 }
 
 args_parser::option &args_parser::add_map(const char *s, char delim1, char delim2) {
-    std::shared_ptr<option> popt = std::make_shared<args_parser::option_map>(*this, s, delim1, delim2);
-    expected_args[current_group].push_back(popt);
-    return *popt.get();
+    std::shared_ptr<option> popt = std::make_shared<args_parser::option_map>(s, delim1, delim2);
+    return add_option(popt);
 }
 
 args_parser::option &args_parser::add_map(const char *s, const char *def, char delim1, char delim2) {
-    std::shared_ptr<option> popt = std::make_shared<args_parser::option_map>(*this, s, def, delim1, delim2);
+    std::shared_ptr<option_map> popt = std::make_shared<args_parser::option_map>(s, def, delim1, delim2);
+    popt->prepare_defaults(*this);
+    return add_option(popt);
+}
+
+std::shared_ptr<const args_parser::schema> args_parser::get_schema() {
+    if (!sch->frozen) {
+        for (auto &group : expected_args)
+            for (auto &opt : group.second)
+                opt->frozen = true;
+        sch->frozen = true;
+    }
+    return sch;
+}
+
+args_parser::option &args_parser::add_option(const std::shared_ptr<option> &popt) {
+    if (sch->frozen)
+        throw std::logic_error("args_parser: can't add an option to a shared schema");
+    popt->index = sch->noptions++;
     expected_args[current_group].push_back(popt);
+    if (current_group != "EXTRA_ARGS") {
+        auto &idx = sch->option_index;
+        idx.insert(std::upper_bound(idx.begin(), idx.end(), popt.get(),
+                                    [](const option *a, const option *b) { return a->str < b->str; }), popt.get());
+    }
+    states.emplace_back();
     return *popt.get();
 }
 
@@ -329,11 +442,11 @@ bool args_parser::match(const std::string &arg, const std::string &pattern) cons
     return true;
 }
 
-bool args_parser::match(const std::string &arg, option &opt) const {
+bool args_parser::match(const std::string &arg, const option &opt) const {
     return match(arg, opt.str);
 }
 
-bool args_parser::get_value(const std::string &arg, option &opt) {
+bool args_parser::get_value(const std::string &arg, const option &opt) {
     size_t offset = 0; 
     assert(prev_option == NULL);
     offset = strlen(option_starter);
@@ -350,7 +463,7 @@ bool args_parser::get_value(const std::string &arg, option &opt) {
             return false;
         offset += 1;
     }
-    bool res = opt.do_parse(arg.c_str() + offset);
+    bool res = opt.do_parse(*this, state(opt), arg.c_str() + offset);
     return res;
 }
 
@@ -375,6 +488,9 @@ void args_parser::print_err(error_t err, std::string option, std::string extra)
             case UNKNOWN_EXTRA_ARGS:
                 sout << "ERROR: Some extra or unknown arguments or options" << std::endl;
                 break;
+            case UNKNOWN_OPTION:
+                sout << "ERROR: Unknown option: " << option << std::endl;
+                break;
             default: throw std::logic_error("args_parser: print_err: unknown error");
         }
     last_error = err;
@@ -402,9 +518,11 @@ void args_parser::print_help_advice() const {
 // each next call with FOREACH_NEXT gives a pointer to the next arg from expected_args
 // together with the pointer to the group name it belongs
 // Two versions are here for ordinary and constant methods, mind the 'const' keyword.
+// The walk position is kept in the parser instance, so that different instances
+// can be used in different threads at the same time.
 bool args_parser::in_expected_args(enum foreach_t t, const std::string *&group, std::shared_ptr<option> *&opt) {
-    static std::map<const std::string, std::vector<std::shared_ptr<option>>>::iterator it;
-    static size_t j = 0;
+    auto &it = foreach_it;
+    size_t &j = foreach_j;
     if (t == FOREACH_FIRST) {
         it = expected_args.begin();
         j = 0;
@@ -429,8 +547,8 @@ bool args_parser::in_expected_args(enum foreach_t t, const std::string *&group,
 }
 
 bool args_parser::in_expected_args(enum foreach_t t, const std::string *&group, const std::shared_ptr<option> *&opt) const {
-    static std::map<const std::string, std::vector<std::shared_ptr<option>>>::const_iterator cit;
-    static size_t j = 0;
+    auto &cit = foreach_cit;
+    size_t &j = foreach_cj;
     if (t == FOREACH_FIRST) {
         cit = expected_args.begin();
         j = 0;
@@ -486,7 +604,7 @@ void args_parser::print_help() const {
     std::string tab(size - 2, ' ');
     bool is_there_sys_group = false, is_there_empty_group = false;
     // help
-    std::shared_ptr<option> helpopt = std::make_shared<option_scalar>(*this, "help", BOOL); 
+    std::shared_ptr<option> helpopt = std::make_shared<option_scalar>("help", BOOL); 
     helpopt->flag = true;
     print_single_option_usage(helpopt, "");
     // help option
@@ -573,7 +691,7 @@ void args_parser::print() const {
     const std::shared_ptr<option> *popt;
     in_expected_args(FOREACH_FIRST, pgroup, popt);
     while(in_expected_args(FOREACH_NEXT, pgroup, popt)) {
-        (*popt)->print();
+        (*popt)->print(sout, get_state(**popt));
     }
 }
 
@@ -631,11 +749,12 @@ bool args_parser::parse() {
         if (prev_option) {
             // the option itself was given as a previous argv[i] 
             // now only parse the option argument
-            option &opt = *prev_option;
+            const option &opt = *prev_option;
+            option_state &st = state(opt);
             if (!opt.required && opt.defaultize_before_parsing) 
-                opt.set_default_value();
-            opt.defaulted = false;
-            if (!opt.do_parse(arg.c_str())) {
+                opt.set_default_value(*this, st);
+            st.defaulted = false;
+            if (!opt.do_parse(*this, st, arg.c_str())) {
                 print_err(PARSE_ERROR_OPTION, opt.str, arg);
                 parse_result = false;
             }
@@ -664,11 +783,12 @@ bool args_parser::parse() {
             if (*pgroup == "EXTRA_ARGS")
                 continue;
             if (match(arg, **popt)) {
+                option_state &st = state(**popt);
                 if (!(*popt)->required && (*popt)->defaultize_before_parsing)
-                    (*popt)->set_default_value();
-                (*popt)->defaulted = false;
+                    (*popt)->set_default_value(*this, st);
+                st.defaulted = false;
                 if ((*popt)->flag) {
-                    (*popt)->do_parse("on");
+                    (*popt)->do_parse(*this, st, "on");
                     found = true;
                     break;
                 }
@@ -704,10 +824,11 @@ bool args_parser::parse() {
                break;
             if (match(unknown_args[j], "")) 
                 continue;
+            option_state &st = state(*extra_args[j]);
             if (!extra_args[j]->required && extra_args[j]->defaultize_before_parsing)
-                extra_args[j]->set_default_value();
-            extra_args[j]->defaulted = false;
-            if (!extra_args[j]->do_parse(unknown_args[j].c_str())) {
+                extra_args[j]->set_default_value(*this, st);
+            st.defaulted = false;
+            if (!extra_args[j]->do_parse(*this, st, unknown_args[j].c_str())) {
                 print_err(PARSE_ERROR_EXTRA_ARGS, "", unknown_args[j]);
                 parse_result = false;
                 break;
@@ -723,11 +844,12 @@ bool args_parser::parse() {
     std::shared_ptr<option> *popt;
     in_expected_args(FOREACH_FIRST, pgroup, popt);
     while(in_expected_args(FOREACH_NEXT, pgroup, popt)) {
-        if ((*popt)->is_default_setting_required()) {
-            (*popt)->set_default_value();
+        option_state &st = state(**popt);
+        if ((*popt)->is_default_setting_required(st)) {
+            (*popt)->set_default_value(*this, st);
             continue;
         }
-        if ((*popt)->is_required_but_not_set()) {
+        if ((*popt)->is_required_but_not_set(st)) {
             print_err(NO_REQUIRED_OPTION, (*popt)->str);
             parse_result = false;
         }
@@ -745,7 +867,187 @@ bool args_parser::parse() {
     return parse_result;
 }
 
+const args_parser::option *args_parser::find_option(const char *name, size_t len) const {
+    const std::vector<const option *> &option_index = sch->option_index;
+    auto it = std::lower_bound(option_index.begin(), option_index.end(), std::make_pair(name, len),
+                               [](const option *a, const std::pair<const char *, size_t> &b) { return a->str.compare(0, std::string::npos, b.first, b.second) < 0; });
+    if (it == option_index.end() || (*it)->str.compare(0, std::string::npos, name, len) != 0)
+        return NULL;
+    return *it;
+}
+
+bool args_parser::apply(int ntokens, const char * const *tokens) {
+    if (!parse_done)
+        throw std::logic_error("args_parser: apply() is possible only after parse()");
+    bool result = true;
+    std::vector<const option *> touched;
+    size_t starter_len = strlen(option_starter);
+    for (int i = 0; i < ntokens; i++) {
+        const char *arg = tokens[i];
+        if (strncmp(arg, option_starter, starter_len)) {
+            print_err(UNKNOWN_OPTION, arg);
+            result = false;
+            continue;
+        }
+        const char *name = arg + starter_len;
+        const char *delim = (option_delimiter == ' ' ? NULL : strchr(name, option_delimiter));
+        size_t len = (delim ? (size_t)(delim - name) : strlen(name));
+        const option *opt = find_option(name, len);
+        if (!opt) {
+            print_err(UNKNOWN_OPTION, arg);
+            result = false;
+            continue;
+        }
+        option_state &st = state(*opt);
+        if (std::find(touched.begin(), touched.end(), opt) == touched.end()) {
+            opt->reset(st);
+            if (!opt->required && opt->defaultize_before_parsing)
+                opt->set_default_value(*this, st);
+            touched.push_back(opt);
+        }
+        st.defaulted = false;
+        const char *sval = NULL;
+        if (opt->flag) {
+            sval = "on";
+        } else if (option_delimiter == ' ') {
+            sval = (i + 1 < ntokens ? tokens[++i] : NULL);
+        } else {
+            sval = (delim ? delim + 1 : NULL);
+        }
+        if (!sval || !opt->do_parse(*this, st, sval)) {
+            print_err(PARSE_ERROR_OPTION, opt->str, sval ? sval : "");
+            result = false;
+        }
+    }
+    for (auto opt : touched) {
+        option_state &st = state(*opt);
+        if (opt->is_default_setting_required(st)) {
+            opt->set_default_value(*this, st);
+            continue;
+        }
+        if (opt->is_required_but_not_set(st)) {
+            print_err(NO_REQUIRED_OPTION, opt->str);
+            result = false;
+        }
+    }
+    return result;
+}
+
+struct args_parser::batch_storage {
+    std::vector<std::string> args;
+    std::vector<const char *> argv;
+    std::ostringstream out;
+};
+
+void args_parser::parse_batch_item(const std::shared_ptr<const schema> &shared, batch_item &item) const {
+    // the parser keeps pointers to argv and the stream, so it owns them rather than the item
+    auto storage = std::make_shared<batch_storage>();
+    storage->args = item.args;
+    for (auto &arg : storage->args)
+        storage->argv.push_back(arg.c_str());
+    item.parser = std::make_shared<args_parser>(shared, (int)storage->argv.size(), storage->argv.data(),
+                                                option_starter, option_delimiter, storage->out);
+    item.parser->storage = storage;
+    item.parser->flags = flags;
+    item.parser->program_name = program_name;
+    item.result = item.parser->parse();
+    item.error = item.parser->get_last_error(item.error_option, item.error_extra);
+    item.messages = storage->out.str();
+}
+
+size_t args_parser::parse_batch(std::vector<batch_item> &items, unsigned nthreads) {
+    std::shared_ptr<const schema> shared = get_schema();
+    if (nthreads == 0)
+        nthreads = std::max(std::thread::hardware_concurrency(), 1u);
+    nthreads = (unsigned)std::min((size_t)nthreads, items.size());
+    // each worker picks up the next unparsed item, so the slow ones don't hold the rest
+    std::atomic<size_t> next(0);
+    std::vector<std::exception_ptr> errors(nthreads);
+    auto worker = [&](unsigned t) {
+        try {
+            for (size_t i = next++; i < items.size(); i = next++)
+                parse_batch_item(shared, items[i]);
+        }
+        catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < nthreads; t++)
+        threads.emplace_back(worker, t);
+    if (nthreads)
+        worker(0);
+    for (auto &thread : threads)
+        thread.join();
+    for (auto &error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+    size_t nparsed = 0;
+    for (auto &item : items)
+        nparsed += item.result ? 1 : 0;
+    return nparsed;
+}
+
+size_t args_parser::parse_batch(const std::vector<std::vector<std::string>> &argsets, std::vector<batch_item> &items,
+                                unsigned nthreads) {
+    std::string argv0 = (argv && argc > 0 ? argv[0] : program_name);
+    items.clear();
+    items.resize(argsets.size());
+    for (size_t i = 0; i < argsets.size(); i++) {
+        items[i].args.push_back(argv0);
+        items[i].args.insert(items[i].args.end(), argsets[i].begin(), argsets[i].end());
+    }
+    return parse_batch(items, nthreads);
+}
+
+static void split_line(const std::string &line, std::vector<std::string> &words) {
+    std::string word;
+    bool in_word = false;
+    char quote = 0;
+    for (char c : line) {
+        if (quote) {
+            if (c == quote)
+                quote = 0;
+            else
+                word += c;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            in_word = true;
+        } else if (isspace((unsigned char)c)) {
+            if (in_word)
+                words.push_back(word);
+            word.clear();
+            in_word = false;
+        } else {
+            word += c;
+            in_word = true;
+        }
+    }
+    if (in_word)
+        words.push_back(word);
+}
+
+size_t args_parser::parse_batch(std::istream &in, std::vector<batch_item> &items, unsigned nthreads) {
+    std::string argv0 = (argv && argc > 0 ? argv[0] : program_name);
+    items.clear();
+    std::string line;
+    for (size_t n = 1; std::getline(in, line); n++) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+        batch_item item;
+        item.line = n;
+        item.args.push_back(argv0);
+        split_line(line, item.args);
+        items.push_back(item);
+    }
+    return parse_batch(items, nthreads);
+}
+
 args_parser::option &args_parser::set_caption(int n, const char *cap) {
+    if (sch->frozen)
+        throw std::logic_error("args_parser: can't change an option of a shared schema");
     int num_extra_args = 0, num_required_extra_args = 0;
     auto &extra_args = get_extra_args_info(num_extra_args, num_required_extra_args);
     if (n >= num_extra_args)
@@ -760,7 +1062,7 @@ std::vector<args_parser::value> args_parser::get_result_value(const std::string
     in_expected_args(FOREACH_FIRST, pgroup, popt);
     while(in_expected_args(FOREACH_NEXT, pgroup, popt)) {
         if ((*popt)->str == s) {
-            return (*popt)->get_value_as_vector();
+            return (*popt)->get_value_as_vector(get_state(**popt));
         }
     }
     throw std::logic_error("args_parser: no such option");
@@ -772,7 +1074,7 @@ void args_parser::get_result_map(const std::string &s, std::map<std::string, std
     in_expected_args(FOREACH_FIRST, pgroup, popt);
     while(in_expected_args(FOREACH_NEXT, pgroup, popt)) {
         if ((*popt)->str == s) {
-            if (!(*popt)->get_value_as_map(r))
+            if (!(*popt)->get_value_as_map(get_state(**popt), r))
                 throw std::logic_error("args_parser: no such option");
             else
                 return;
@@ -785,6 +1087,137 @@ void args_parser::get(const std::string &s, std::map<std::string, std::string> &
     get_result_map(s, r);
 }
 
+void args_parser::get_options(size_t n, const char * const *names, const option **result) const {
+    std::vector<size_t> sorted(n);
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = i;
+        result[i] = NULL;
+    }
+    std::sort(sorted.begin(), sorted.end(), [names](size_t a, size_t b) { return strcmp(names[a], names[b]) < 0; });
+    for (auto &group : expected_args) {
+        for (auto &opt : group.second) {
+            const char *str = opt->str.c_str();
+            auto it = std::lower_bound(sorted.begin(), sorted.end(), str,
+                                       [names](size_t a, const char *b) { return strcmp(names[a], b) < 0; });
+            // the same name can be requested several times; the first option found wins
+            for (; it != sorted.end() && strcmp(names[*it], str) == 0; ++it) {
+                if (!result[*it])
+                    result[*it] = opt.get();
+            }
+        }
+    }
+}
+
+// Heap bytes of a string, zero when the small string optimization keeps it
+// inside the string object
+static size_t heap_bytes(const std::string &s) {
+    uintptr_t data = (uintptr_t)s.data(), obj = (uintptr_t)&s;
+    if (data >= obj && data < obj + sizeof(s))
+        return 0;
+    return s.capacity() + 1;
+}
+
+static size_t heap_bytes(const std::vector<args_parser::value> &v) {
+    size_t n = v.capacity() * sizeof(args_parser::value);
+    for (auto &x : v)
+        n += heap_bytes(x.str);
+    return n;
+}
+
+// besides the element, a tree node holds three links and the color
+static const size_t map_node_overhead = 4 * sizeof(void *);
+
+static size_t heap_bytes(const std::map<std::string, std::string> &m) {
+    size_t n = 0;
+    for (auto &kv : m)
+        n += map_node_overhead + sizeof(kv) + heap_bytes(kv.first) + heap_bytes(kv.second);
+    return n;
+}
+
+static void common_footprint(const args_parser::option &opt, size_t object_size, args_parser::footprint &f) {
+    f.bytes[args_parser::footprint::OPTIONS] += object_size + sizeof(args_parser::option_state);
+    f.bytes[args_parser::footprint::TEXT] += heap_bytes(opt.str) + heap_bytes(opt.caption) + heap_bytes(opt.description);
+}
+
+const char *args_parser::footprint::get_category_str(category_t c) {
+    switch (c) {
+        case OPTIONS: return "options";
+        case VALUES: return "values";
+        case KVMAPS: return "kvmaps";
+        case TEXT: return "text";
+        case UNKNOWN_ARGS: return "unknown_args";
+        default: assert(NULL == "Impossible case in switch(category)");
+    }
+    return "";
+}
+
+void args_parser::option_scalar::get_footprint(const option_state &st, footprint &f) const {
+    common_footprint(*this, sizeof(*this), f);
+    f.bytes[footprint::VALUES] += heap_bytes(def.str) + heap_bytes(st.val.str);
+}
+
+void args_parser::option_vector::get_footprint(const option_state &st, footprint &f) const {
+    common_footprint(*this, sizeof(*this), f);
+    f.bytes[footprint::TEXT] += heap_bytes(vec_def);
+    // st.shared_vals refers to def_vals, so only the own copy is counted
+    f.bytes[footprint::VALUES] += heap_bytes(st.vals);
+    if (def_vals)
+        f.bytes[footprint::VALUES] += sizeof(*def_vals) + heap_bytes(*def_vals);
+}
+
+void args_parser::option_map::get_footprint(const option_state &st, footprint &f) const {
+    common_footprint(*this, sizeof(*this), f);
+    f.bytes[footprint::TEXT] += heap_bytes(vec_def);
+    f.bytes[footprint::VALUES] += heap_bytes(st.vals);
+    f.bytes[footprint::KVMAPS] += heap_bytes(st.kvmap);
+    if (def_vals)
+        f.bytes[footprint::VALUES] += sizeof(*def_vals) + heap_bytes(*def_vals);
+    if (def_kvmap)
+        f.bytes[footprint::KVMAPS] += sizeof(*def_kvmap) + heap_bytes(*def_kvmap);
+}
+
+void args_parser::get_footprint(footprint_report &report) const {
+    report = footprint_report();
+    for (auto &group : expected_args) {
+        footprint &g = report.groups[group.first];
+        g.bytes[footprint::OPTIONS] += map_node_overhead + sizeof(group) +
+                                       group.second.capacity() * sizeof(std::shared_ptr<option>);
+        g.bytes[footprint::TEXT] += heap_bytes(group.first);
+        for (auto &opt : group.second) {
+            footprint f;
+            opt->get_footprint(get_state(*opt), f);
+            g += f;
+            report.options.push_back(std::make_pair(opt->str, f));
+        }
+        report.total += g;
+    }
+    // the parser itself, the name index and the spare capacity of the states
+    report.total.bytes[footprint::OPTIONS] += sizeof(*this) + sizeof(schema) +
+                                              sch->option_index.capacity() * sizeof(const option *) +
+                                              (states.capacity() - states.size()) * sizeof(option_state);
+    report.total.bytes[footprint::UNKNOWN_ARGS] += unknown_args.capacity() * sizeof(std::string);
+    for (auto &arg : unknown_args)
+        report.total.bytes[footprint::UNKNOWN_ARGS] += heap_bytes(arg);
+}
+
+void args_parser::print_footprint() const {
+    footprint_report report;
+    get_footprint(report);
+    auto print_line = [this](const footprint &f) {
+        sout << f.total() << " bytes (";
+        for (int i = 0; i < footprint::NCATEGORIES; i++) {
+            sout << (i ? ", " : "") << footprint::get_category_str((footprint::category_t)i) << ": " << f.bytes[i];
+        }
+        sout << ")" << std::endl;
+    };
+    sout << "Memory footprint: ";
+    print_line(report.total);
+    for (auto &group : report.groups) {
+        sout << "  group \"" << group.first << "\": ";
+        print_line(group.second);
+    }
+}
+
 void args_parser::get_unknown_args(std::vector<std::string> &r) const {
     for (size_t j = 0; j < unknown_args.size(); j++) {
         r.push_back(unknown_args[j]);
@@ -803,11 +1236,13 @@ bool args_parser::load(std::istream &in_stream) {
         while(in_expected_args(FOREACH_NEXT, pgroup, popt)) {
             if (*pgroup == "SYS" || *pgroup == "EXTRA_ARGS")
                 continue;
-            if (parse_done && !((*popt)->defaulted || (*popt)->is_map()))
+            option_state &st = state(**popt);
+            if (parse_done && !(st.defaulted || (*popt)->is_map()))
                 continue;
             if(stream[(*popt)->str.c_str()]) {
                 const YAML::Node Name = stream[(*popt)->str.c_str()].as<YAML::Node>();
-                Name >> **popt;
+                (*popt)->from_yaml(Name, st);
+                st.defaulted = false;
             }
         }
         int num_extra_args = 0, num_required_extra_args = 0;
@@ -819,7 +1254,9 @@ bool args_parser::load(std::istream &in_stream) {
                 if (j == num_extra_args) 
                     break;
                 popt = &extra_args[j];
-                *it >> **popt;
+                option_state &st = state(**popt);
+                (*popt)->from_yaml(*it, st);
+                st.defaulted = false;
             }
         }
     }
@@ -868,16 +1305,19 @@ std::string args_parser::dump() const {
     while(in_expected_args(FOREACH_NEXT, pgroup, popt)) {
         if (*pgroup == "SYS" || *pgroup == "EXTRA_ARGS")
             continue;
-        if ((*popt)->defaulted) {
+        const option_state &st = get_state(**popt);
+        if (st.defaulted) {
             YAML::Emitter comment;
             comment << YAML::BeginMap;
             comment << YAML::Flow << YAML::Key << (*popt)->str.c_str();
-            comment << YAML::Flow << YAML::Value << **popt;
+            comment << YAML::Flow << YAML::Value;
+            (*popt)->to_yaml(comment, st);
             comment << YAML::EndMap;
             out << YAML::Flow << YAML::Newline << YAML::Comment(comment.c_str()) << YAML::Comment("(default)");
         } else {
             out << YAML::Key << (*popt)->str.c_str();
-            out << YAML::Value << **popt;
+            out << YAML::Value;
+            (*popt)->to_yaml(out, st);
         }
     }
     int num_extra_args = 0, num_required_extra_args = 0;
@@ -887,12 +1327,14 @@ std::string args_parser::dump() const {
         out << YAML::Value << YAML::BeginSeq << YAML::Newline;
         for (int i = 0; i < num_extra_args; i++) {
             popt = &extra_args[i];
-            if ((*popt)->defaulted) {
+            const option_state &st = get_state(**popt);
+            if (st.defaulted) {
                 YAML::Emitter comment;
-                comment << YAML::Flow << **popt;
+                comment << YAML::Flow;
+                (*popt)->to_yaml(comment, st);
                 out << YAML::Flow << YAML::Newline << YAML::Comment(comment.c_str()) << YAML::Comment("(default)");
             } else {
-                out << **popt;
+                (*popt)->to_yaml(out, st);
             }
         }
         out << YAML::Newline << YAML::EndSeq;
@@ -901,6 +1343,101 @@ std::string args_parser::dump() const {
     out << YAML::Newline;
     return std::string(out.c_str());
 }
+
+static bool same_as_yaml(const args_parser::option &opt, const args_parser::option_state &st, const YAML::Node &node) {
+    try {
+        if (opt.is_map()) {
+            const auto &kvmap = st.get_kvmap();
+            if (!node.IsMap() || node.size() != kvmap.size())
+                return false;
+            for (auto it = node.begin(); it != node.end(); ++it) {
+                auto kv = kvmap.find(it->first.as<std::string>());
+                if (kv == kvmap.end() || kv->second != it->second.as<std::string>())
+                    return false;
+            }
+            return true;
+        }
+        const args_parser::value *vals = NULL;
+        size_t n = opt.get_values(st, vals);
+        args_parser::value v;
+        v.type = opt.type;
+        if (opt.is_scalar()) {
+            if (n != 1 || !node.IsScalar())
+                return false;
+            node >> v;
+            return v == vals[0];
+        }
+        if (!node.IsSequence() || node.size() != n)
+            return false;
+        for (size_t i = 0; i < n; i++) {
+            node[i] >> v;
+            if (!(v == vals[i]))
+                return false;
+        }
+        return true;
+    }
+    catch (const YAML::Exception &) {
+        return false;
+    }
+}
+
+bool args_parser::diff(const std::string &input, std::vector<diff_entry> &result) const {
+    result.clear();
+    YAML::Node stream;
+    try {
+        stream = YAML::Load(input);
+    }
+    catch (const YAML::Exception& e) {
+        sout << "ERROR: input YAML file parsing error: " << e.what() << std::endl;
+        return false;
+    }
+    if (!stream.IsMap()) {
+        sout << "ERROR: input YAML file parsing error: map is expected" << std::endl;
+        return false;
+    }
+    const YAML::Node &cstream = stream;
+    std::vector<const std::string *> names;
+    for (auto &group : expected_args) {
+        if (group.first == "SYS")
+            continue;
+        bool positional = (group.first == "EXTRA_ARGS");
+        const YAML::Node extra_args = (positional ? cstream["extra_args"] : YAML::Node());
+        for (size_t j = 0; j < group.second.size(); j++) {
+            const option &opt = *group.second[j];
+            if (!positional)
+                names.push_back(&opt.str);
+            bool has_extra_arg = (extra_args && extra_args.IsSequence() && j < extra_args.size());
+            const YAML::Node node = (positional ? (has_extra_arg ? extra_args[j] : YAML::Node()) : cstream[opt.str]);
+            const option_state &st = get_state(opt);
+            diff_entry entry { diff_entry::CHANGED, group.first, opt.str, &opt, NULL };
+            if (positional ? !has_extra_arg : !node) {
+                if (st.defaulted)
+                    continue;
+                // the other side has the schema default value
+                option_state def;
+                if (!opt.required)
+                    opt.set_default_value(*this, def);
+                if (same_value(opt, st, opt, def))
+                    entry.kind = diff_entry::DEFAULTED;
+            } else if (same_as_yaml(opt, st, node)) {
+                if (!st.defaulted)
+                    continue;
+                entry.kind = diff_entry::DEFAULTED;
+            }
+            result.push_back(entry);
+        }
+    }
+    auto by_name = [](const std::string *a, const std::string *b) { return *a < *b; };
+    std::sort(names.begin(), names.end(), by_name);
+    for (auto it = cstream.begin(); it != cstream.end(); ++it) {
+        const std::string key = it->first.as<std::string>();
+        if (key == "version" || key == "extra_args")
+            continue;
+        if (!std::binary_search(names.begin(), names.end(), &key, by_name))
+            result.push_back(diff_entry { diff_entry::ADDED, "", key, NULL, NULL });
+    }
+    return true;
+}
 #endif
 
 bool args_parser::is_option(const std::string &str) const {
@@ -908,13 +1445,196 @@ bool args_parser::is_option(const std::string &str) const {
     return false;
 }
 
+static const uint64_t fnv_offset = 14695981039346656037ULL;
+static const uint64_t fnv_prime = 1099511628211ULL;
+
+// The hash is taken over a canonical encoding, so that it doesn't depend on the platform:
+// integers are 8 bytes little-endian, floating point values are their IEEE-754 bit patterns
+// as integers, bools and type tags are single bytes, strings are length and bytes.
+static inline uint64_t fnv1a(uint64_t h, const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= fnv_prime;
+    }
+    return h;
+}
+
+static inline uint64_t fnv1a_u8(uint64_t h, uint8_t x) { return fnv1a(h, &x, 1); }
+
+static inline uint64_t fnv1a_u64(uint64_t h, uint64_t x) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++)
+        bytes[i] = (unsigned char)(x >> (8 * i));
+    return fnv1a(h, bytes, 8);
+}
+
+static inline uint64_t fnv1a_str(uint64_t h, const std::string &s) {
+    // the length goes first so that adjacent strings can't shift into each other
+    return fnv1a(fnv1a_u64(h, (uint64_t)s.size()), s.data(), s.size());
+}
+
+static inline uint64_t fnv1a_double(uint64_t h, double d) {
+    // -0.0 and 0.0 are the same value, all NaNs are the same too
+    uint64_t bits = 0x7ff8000000000000ULL;
+    if (d == 0)
+        bits = 0;
+    else if (d == d)
+        memcpy(&bits, &d, sizeof(bits));
+    return fnv1a_u64(h, bits);
+}
+
+// Fixed tags of arg_t values, the enum may be reordered freely
+static uint8_t hash_tag(args_parser::arg_t type) {
+    switch (type) {
+        case args_parser::STRING: return 1;
+        case args_parser::INT: return 2;
+        case args_parser::INT64: return 3;
+        case args_parser::FLOAT: return 4;
+        case args_parser::DOUBLE: return 5;
+        case args_parser::BOOL: return 6;
+    }
+    return 0;
+}
+
+// splitmix64 finalizer
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static uint64_t hash_value(uint64_t h, const args_parser::value &v) {
+    h = fnv1a_u8(h, v.is_initialized() ? 1 : 0);
+    if (!v.is_initialized())
+        return h;
+    h = fnv1a_u8(h, hash_tag(v.type));
+    switch (v.type) {
+        case args_parser::INT: h = fnv1a_u64(h, (uint64_t)(int64_t)v.i); break;
+        // a float is widened to double exactly, so its encoding doesn't depend on its size
+        case args_parser::FLOAT: h = fnv1a_double(h, (double)v.f); break;
+        case args_parser::BOOL: h = fnv1a_u8(h, v.b ? 1 : 0); break;
+        case args_parser::INT64: h = fnv1a_u64(h, (uint64_t)v.i64); break;
+        case args_parser::DOUBLE: h = fnv1a_double(h, v.d); break;
+        case args_parser::STRING: h = fnv1a_str(h, v.str); break;
+    }
+    return h;
+}
+
+uint64_t args_parser::hash() const {
+    uint64_t sum = 0;
+    size_t nopts = 0;
+    for (auto &group : expected_args) {
+        bool positional = (group.first == "EXTRA_ARGS");
+        for (size_t j = 0; j < group.second.size(); j++) {
+            const option &opt = *group.second[j];
+            uint64_t h = fnv1a_str(fnv_offset, opt.str);
+            if (positional)
+                h = fnv1a_u64(h, (uint64_t)j + 1);
+            h = fnv1a_u8(h, hash_tag(opt.type));
+            const option_state &st = get_state(opt);
+            h = fnv1a_u8(h, st.defaulted ? 1 : 0);
+            h = fnv1a_u8(h, opt.is_map() ? 1 : 0);
+            if (opt.is_map()) {
+                // the map itself, sorted by key: the raw "k=v" tokens keep the order they
+                // were given in, and load() fills in the map only
+                const auto &kvmap = st.get_kvmap();
+                h = fnv1a_u64(h, (uint64_t)kvmap.size());
+                for (auto &kv : kvmap) {
+                    h = fnv1a_str(h, kv.first);
+                    h = fnv1a_str(h, kv.second);
+                }
+            } else {
+                const value *vals = NULL;
+                size_t n = opt.get_values(st, vals);
+                h = fnv1a_u64(h, (uint64_t)n);
+                for (size_t i = 0; i < n; i++)
+                    h = hash_value(h, vals[i]);
+            }
+            // summing up the mixed per-option hashes makes the result order-independent
+            sum += mix64(h);
+            nopts++;
+        }
+    }
+    uint64_t h = fnv1a_u64(fnv_offset, (uint64_t)unknown_args.size());
+    for (auto &arg : unknown_args)
+        h = fnv1a_str(h, arg);
+    sum += mix64(h ^ 0x9e3779b97f4a7c15ULL);
+    return mix64(sum ^ mix64((uint64_t)nopts));
+}
+
+bool args_parser::same_value(const option &a, const option_state &as, const option &b, const option_state &bs) {
+    if (a.type != b.type || a.is_map() != b.is_map() || a.is_scalar() != b.is_scalar())
+        return false;
+    if (a.is_map())
+        return as.get_kvmap() == bs.get_kvmap();
+    const value *avals = NULL, *bvals = NULL;
+    size_t n = a.get_values(as, avals);
+    if (b.get_values(bs, bvals) != n)
+        return false;
+    for (size_t i = 0; i < n; i++) {
+        if (!(avals[i] == bvals[i]))
+            return false;
+    }
+    return true;
+}
+
+void args_parser::diff(const args_parser &other, std::vector<diff_entry> &result) const {
+    typedef std::pair<const std::string *, const option *> item_t;
+    auto flatten = [](const args_parser &p, std::vector<item_t> &items) {
+        for (auto &group : p.expected_args) {
+            if (group.first == "SYS")
+                continue;
+            for (auto &opt : group.second)
+                items.push_back(item_t(&group.first, opt.get()));
+        }
+    };
+    result.clear();
+    std::vector<item_t> left, right;
+    flatten(*this, left);
+    flatten(other, right);
+    // parsers of the same schema are walked pairwise as they are; otherwise
+    // both sides are ordered by name and merged
+    bool same_layout = (left.size() == right.size());
+    for (size_t i = 0; same_layout && i < left.size(); i++)
+        same_layout = (left[i].second->str == right[i].second->str);
+    if (!same_layout) {
+        auto by_name = [](const item_t &a, const item_t &b) { return a.second->str < b.second->str; };
+        std::stable_sort(left.begin(), left.end(), by_name);
+        std::stable_sort(right.begin(), right.end(), by_name);
+    }
+    size_t i = 0, j = 0;
+    while (i < left.size() || j < right.size()) {
+        int cmp = (i == left.size() ? 1 : (j == right.size() ? -1 : left[i].second->str.compare(right[j].second->str)));
+        if (cmp < 0) {
+            result.push_back(diff_entry { diff_entry::REMOVED, *left[i].first, left[i].second->str, left[i].second, NULL });
+            i++;
+        } else if (cmp > 0) {
+            result.push_back(diff_entry { diff_entry::ADDED, *right[j].first, right[j].second->str, NULL, right[j].second });
+            j++;
+        } else {
+            const option &l = *left[i].second, &r = *right[j].second;
+            const option_state &ls = get_state(l), &rs = other.get_state(r);
+            if (!same_value(l, ls, r, rs))
+                result.push_back(diff_entry { diff_entry::CHANGED, *left[i].first, l.str, &l, &r });
+            else if (ls.defaulted != rs.defaulted)
+                result.push_back(diff_entry { diff_entry::DEFAULTED, *left[i].first, l.str, &l, &r });
+            i++;
+            j++;
+        }
+    }
+}
+
 bool args_parser::is_option_defaulted(const std::string &str) const {
     const std::string *pgroup;
     const std::shared_ptr<option> *popt;
     in_expected_args(FOREACH_FIRST, pgroup, popt);
     while(in_expected_args(FOREACH_NEXT, pgroup, popt)) {
         if ((*popt)->str == str) {
-            return (*popt)->defaulted;
+            return get_state(**popt).defaulted;
         }
     }
     return false;
@@ -931,17 +1651,14 @@ bool args_parser::is_help_mode() const {
 }
 
 
-std::ostream &operator<<(std::ostream &s, const args_parser::option &opt) {
-    opt.to_ostream(s);
-    return s;
-}
-
 std::ostream &operator<<(std::ostream &s, const args_parser::value &val) {
     switch(val.type) {
         case args_parser::STRING: s << val.str; break;
         case args_parser::INT: s << val.i; break;
         case args_parser::FLOAT: s << val.f; break;
         case args_parser::BOOL: s << val.b; break;
+        case args_parser::INT64: s << val.i64; break;
+        case args_parser::DOUBLE: s << val.d; break;
         default: assert(NULL == "Impossible case in switch(type)");
     }
     return s;
@@ -951,9 +1668,13 @@ template <> args_parser::arg_t get_arg_t<int>() { return args_parser::INT; }
 template <> args_parser::arg_t get_arg_t<float>() { return args_parser::FLOAT; }
 template <> args_parser::arg_t get_arg_t<std::string>() { return args_parser::STRING; }
 template <> args_parser::arg_t get_arg_t<bool>() { return args_parser::BOOL; }
+template <> args_parser::arg_t get_arg_t<int64_t>() { return args_parser::INT64; }
+template <> args_parser::arg_t get_arg_t<double>() { return args_parser::DOUBLE; }
 
 template <> int get_val<int>(const args_parser::value &v) { return v.i; }
 template <> float get_val<float>(const args_parser::value &v) { return v.f; }
 template <> bool get_val<bool>(const args_parser::value &v) { return v.b; }
 template <> std::string get_val<std::string>(const args_parser::value &v) { return v.str; }
+template <> int64_t get_val<int64_t>(const args_parser::value &v) { return v.i64; }
+template <> double get_val<double>(const args_parser::value &v) { return v.d; }
 
@@ -28,6 +28,7 @@
 #include <set>
 #include <stdexcept>
 #include <memory>
+#include <stdint.h>
 #ifdef WITH_YAML_CPP
 #include "yaml-cpp/yaml.h"
 #endif
@@ -44,18 +45,45 @@ class args_parser {
     bool parse_done = false;
 
     public:
-    args_parser() : argc(0), argv(0), option_starter("--"), option_delimiter('='), sout(std::cout), prev_option(NULL), last_error(NONE) {}
+    struct schema;
+    args_parser() : argc(0), argv(0), option_starter("--"), option_delimiter('='), sout(std::cout),
+                    sch(std::make_shared<schema>()), expected_args(sch->expected_args), prev_option(NULL), last_error(NONE) {}
     args_parser(int _argc, const char * const *_argv, const char *opt_st = "--", 
                 char opt_delim = '=', std::ostream &_sout = std::cout) : argc(_argc), argv(_argv), 
                                                                          option_starter(opt_st), 
                                                                          option_delimiter(opt_delim), 
                                                                          sout(_sout),
+                                                                         sch(std::make_shared<schema>()),
+                                                                         expected_args(sch->expected_args),
                                                                          prev_option(NULL),
                                                                          last_error(NONE)  
     { auto &dummy = expected_args["EXTRA_ARGS"]; (void)dummy; } 
-    typedef enum { STRING, INT, FLOAT, BOOL } arg_t;
+    // A parser instance on a schema shared with other instances, see get_schema():
+    // nothing but the option_state array is allocated per instance
+    args_parser(const std::shared_ptr<const schema> &_schema, int _argc, const char * const *_argv, 
+                const char *opt_st = "--", char opt_delim = '=', std::ostream &_sout = std::cout) : 
+                                                                         argc(_argc), argv(_argv), 
+                                                                         option_starter(opt_st), 
+                                                                         option_delimiter(opt_delim), 
+                                                                         sout(_sout),
+                                                                         sch(std::const_pointer_cast<schema>(_schema)),
+                                                                         expected_args(sch->expected_args),
+                                                                         states(sch->noptions),
+                                                                         prev_option(NULL),
+                                                                         last_error(NONE)  
+    { 
+        if (!sch->frozen)
+            throw std::logic_error("args_parser: the schema is not shared, see get_schema()");
+    }
+    // A copy would share the mutable schema with the source, while keeping its own
+    // option_state array; use get_schema() and the constructor above instead
+    args_parser(const args_parser &) = delete;
+    args_parser &operator=(const args_parser &) = delete;
+    // INT64 values may have a power-of-two multiplier suffix: K or Ki (2^10), M or Mi (2^20),
+    // G or Gi (2^30), T or Ti (2^40); e.g. --size=4G. Overflow is a parse error.
+    typedef enum { STRING, INT, FLOAT, BOOL, INT64, DOUBLE } arg_t;
     typedef enum { ALLOW_UNEXPECTED_ARGS, SILENT, NOHELP, NODUPLICATE /*, NODEFAULTSDUMP*/ } flag_t;
-    typedef enum { NONE, NO_REQUIRED_OPTION, NO_REQUIRED_EXTRA_ARG, PARSE_ERROR_OPTION, PARSE_ERROR_EXTRA_ARGS, UNKNOWN_EXTRA_ARGS } error_t;
+    typedef enum { NONE, NO_REQUIRED_OPTION, NO_REQUIRED_EXTRA_ARG, PARSE_ERROR_OPTION, PARSE_ERROR_EXTRA_ARGS, UNKNOWN_EXTRA_ARGS, UNKNOWN_OPTION } error_t;
 
     class value {
         public:
@@ -65,6 +93,8 @@ class args_parser {
             value(bool v) : initialized(true), i(0), f(0), str("(none)") { type = BOOL; b = v; }
             value(std::string v) : initialized(true), i(0), f(0), b(false) { type = STRING; str = v; }
             value(const char *v) : initialized(true), i(0), f(0), b(false) { type = STRING; str.assign(v); }
+            value(int64_t v) : initialized(true), i(0), f(0), str("(none)"), b(false) { type = INT64; i64 = v; }
+            value(double v) : initialized(true), i(0), f(0), str("(none)"), b(false) { type = DOUBLE; d = v; }
             value(const value &other);
         public:
             bool initialized = false;
@@ -72,169 +102,265 @@ class args_parser {
             float f;
             std::string str;
             bool b;
+            int64_t i64 = 0;
+            double d = 0;
             arg_t type;
         public:
             bool is_initialized() const { return initialized; };
             value &operator=(const value &other);
+            bool operator==(const value &other) const;
             bool parse(const char *sval, arg_t _type);
             friend std::ostream &operator<<(std::ostream &s, const args_parser::value &val);
             void sanity_check(arg_t _type) const;
             static const std::string get_type_str(arg_t _type); 
     };
+    // Bytes held by an option, a group or the whole parser, see get_footprint(). These are
+    // object sizes plus the heap taken by container and string capacities; allocator
+    // overhead is not counted.
+    struct footprint {
+        enum category_t { OPTIONS, VALUES, KVMAPS, TEXT, UNKNOWN_ARGS, NCATEGORIES };
+        size_t bytes[NCATEGORIES] = {};
+        size_t total() const { size_t n = 0; for (size_t b : bytes) n += b; return n; }
+        footprint &operator+=(const footprint &other) {
+            for (int i = 0; i < NCATEGORIES; i++) bytes[i] += other.bytes[i];
+            return *this;
+        }
+        static const char *get_category_str(category_t c);
+    };
+    // Per-parse part of an option: parser instances of the same schema keep their own
+    // option_state arrays, the option objects themselves are not changed by parsing
+    struct option_state {
+        args_parser::value val;                        // option_scalar
+        std::vector<args_parser::value> vals;          // option_vector, option_map
+        std::map<std::string, std::string> kvmap;      // option_map
+        // pre-parsed defaults shared with the schema: stand for vals and kvmap until they are changed
+        std::shared_ptr<const std::vector<args_parser::value>> shared_vals;
+        std::shared_ptr<const std::map<std::string, std::string>> shared_kvmap;
+        int num_already_initialized_elems = 0;
+        bool map_always_override = false;
+        bool defaulted = false;
+        const std::vector<args_parser::value> &get_vals() const { return shared_vals ? *shared_vals : vals; }
+        const std::map<std::string, std::string> &get_kvmap() const { return shared_kvmap ? *shared_kvmap : kvmap; }
+        std::vector<args_parser::value> &mutable_vals() {
+            if (shared_vals) { vals = *shared_vals; shared_vals.reset(); }
+            return vals;
+        }
+        std::map<std::string, std::string> &mutable_kvmap() {
+            if (shared_kvmap) { kvmap = *shared_kvmap; shared_kvmap.reset(); }
+            return kvmap;
+        }
+    };
     struct option {
-        const args_parser &parser;
         enum mode { APPLY_DEFAULTS_ONLY_WHEN_MISSING };
         std::string str;
         arg_t type;
         bool required;
         bool defaultize_before_parsing;
-        bool defaulted;
         bool flag;
         std::string caption;
         std::string description;
-        option(const args_parser &_parser, const std::string _str, arg_t _type, bool _required) : parser(_parser), str(_str), 
+        size_t index;  // slot of the option_state in parser instances
+        bool frozen;   // the schema is shared, see get_schema()
+        option(const std::string _str, arg_t _type, bool _required) : str(_str), 
                                                                type(_type), required(_required), 
                                                                defaultize_before_parsing(true), 
-                                                               defaulted(false), flag(false) {};
-        virtual void print() const = 0;
-        virtual bool do_parse(const char *sval) = 0;
+                                                               flag(false), index(0), frozen(false) {};
+        void print(std::ostream &s, const option_state &st) const { s << str << ": "; to_ostream(s, st); s << std::endl; }
+        virtual bool do_parse(const args_parser &p, option_state &st, const char *sval) const = 0;
         virtual bool is_scalar() const = 0;
         virtual bool is_map() const = 0;
-        virtual void set_default_value() = 0;
-        virtual option &set_caption(const std::string &cap) { caption = cap; return *this; }
-        virtual option &set_description(const std::string &descr) { description = descr; return *this; }
+        virtual void set_default_value(const args_parser &p, option_state &st) const = 0;
+        // drops the value as if the option was never given
+        virtual void reset(option_state &st) const = 0;
+        virtual option &set_caption(const std::string &cap) { check_not_frozen(); caption = cap; return *this; }
+        virtual option &set_description(const std::string &descr) { check_not_frozen(); description = descr; return *this; }
         virtual option &set_mode(mode m) { 
+            check_not_frozen();
             if (m == APPLY_DEFAULTS_ONLY_WHEN_MISSING) 
                 defaultize_before_parsing = false; 
             return *this; 
         }
-        virtual bool is_default_setting_required() = 0;
-        virtual bool is_required_but_not_set() = 0;
-        virtual std::vector<args_parser::value> get_value_as_vector() const = 0;
-        virtual bool get_value_as_map(std::map<std::string, std::string> &r) const = 0;
-        virtual void to_ostream(std::ostream &s) const = 0;
-        friend std::ostream &operator<<(std::ostream &s, const args_parser::option &d);
+        virtual bool is_default_setting_required(const option_state &st) const = 0;
+        virtual bool is_required_but_not_set(const option_state &st) const = 0;
+        virtual std::vector<args_parser::value> get_value_as_vector(const option_state &st) const = 0;
+        // zero-copy counterpart of get_value_as_vector(): points to contiguous values
+        virtual size_t get_values(const option_state &st, const args_parser::value *&first) const = 0;
+        virtual bool get_value_as_map(const option_state &st, std::map<std::string, std::string> &r) const = 0;
+        // adds the bytes held by the option and its state
+        virtual void get_footprint(const option_state &st, footprint &f) const = 0;
+        virtual void to_ostream(std::ostream &s, const option_state &st) const = 0;
 #ifdef WITH_YAML_CPP        
-        virtual void to_yaml(YAML::Emitter& out) const = 0;
-        virtual void from_yaml(const YAML::Node& node) = 0;
+        virtual void to_yaml(YAML::Emitter& out, const option_state &st) const = 0;
+        virtual void from_yaml(const YAML::Node& node, option_state &st) const = 0;
 #endif        
         virtual ~option() {}
+        protected:
+        void check_not_frozen() const {
+            if (frozen)
+                throw std::logic_error("args_parser: can't change an option of a shared schema");
+        }
         private:
-        option(const option &other) : parser(other.parser) {}
+        option(const option &) {}
         option &operator=(const option &) { return *this; }
     };
     struct option_scalar : public option {
         args_parser::value def;
-        args_parser::value val;
-        option_scalar(const args_parser &_parser, const std::string _str, arg_t _type) : option(_parser,_str, _type, true) { }
-        option_scalar(const args_parser &_parser, const std::string _str, arg_t _type, const value &_def) : option(_parser, _str, _type, false), def(_def)
+        option_scalar(const std::string _str, arg_t _type) : option(_str, _type, true) { }
+        option_scalar(const std::string _str, arg_t _type, const value &_def) : option(_str, _type, false), def(_def)
         { def.sanity_check(type); }
         virtual ~option_scalar() {}
-        virtual void print() const { parser.sout << str << ": " << val << std::endl; }
-        virtual bool do_parse(const char *sval);
+        virtual bool do_parse(const args_parser &p, option_state &st, const char *sval) const;
         virtual bool is_scalar() const { return true; }
         virtual bool is_map() const { return false; }
-        virtual void to_ostream(std::ostream &s) const { s << val; }
+        virtual void to_ostream(std::ostream &s, const option_state &st) const { s << st.val; }
 #ifdef WITH_YAML_CPP        
-        virtual void to_yaml(YAML::Emitter& out) const;
-        virtual void from_yaml(const YAML::Node& node);
+        virtual void to_yaml(YAML::Emitter& out, const option_state &st) const;
+        virtual void from_yaml(const YAML::Node& node, option_state &st) const;
 #endif        
-        virtual void set_default_value() { val = def; defaulted = true; }
-        virtual bool is_default_setting_required() { return !val.is_initialized() && !required; }
-        virtual bool is_required_but_not_set() { return required && !val.is_initialized(); }
-        virtual std::vector<args_parser::value> get_value_as_vector() const { std::vector<args_parser::value> r; r.push_back(val); return r; }
-        virtual bool get_value_as_map(std::map<std::string, std::string> &) const { return false; }
+        virtual void set_default_value(const args_parser &, option_state &st) const { st.val = def; st.defaulted = true; }
+        virtual void reset(option_state &st) const { st.val.initialized = false; st.defaulted = false; }
+        virtual bool is_default_setting_required(const option_state &st) const { return !st.val.is_initialized() && !required; }
+        virtual bool is_required_but_not_set(const option_state &st) const { return required && !st.val.is_initialized(); }
+        virtual std::vector<args_parser::value> get_value_as_vector(const option_state &st) const { std::vector<args_parser::value> r; r.push_back(st.val); return r; }
+        virtual size_t get_values(const option_state &st, const args_parser::value *&first) const { first = &st.val; return st.val.is_initialized() ? 1 : 0; }
+        virtual bool get_value_as_map(const option_state &, std::map<std::string, std::string> &) const { return false; }
+        virtual void get_footprint(const option_state &st, footprint &f) const;
     };
     struct option_vector : public option {
         enum { MAX_VEC_SIZE = 1024 };
         char vec_delimiter;
         int vec_min;
         int vec_max;
-        int num_already_initialized_elems;
-        std::vector<args_parser::value> val;
         std::string vec_def;
-        option_vector(const args_parser &_parser, const std::string _str, arg_t _type, 
+        std::shared_ptr<const std::vector<args_parser::value>> def_vals;  // vec_def parsed by prepare_defaults()
+        option_vector(const std::string _str, arg_t _type, 
                      char _vec_delimiter, int _vec_min, int _vec_max)  :
-            option(_parser, _str, _type, true), vec_delimiter(_vec_delimiter), vec_min(_vec_min), vec_max(_vec_max)
-        { num_already_initialized_elems = 0; }
-        option_vector(const args_parser &_parser, std::string _str, arg_t _type, 
+            option(_str, _type, true), vec_delimiter(_vec_delimiter), vec_min(_vec_min), vec_max(_vec_max)
+        { }
+        option_vector(std::string _str, arg_t _type, 
                      char _vec_delimiter, int _vec_min, int _vec_max, 
                      const std::string &_vec_def)  :
-            option(_parser, _str, _type, false), vec_delimiter(_vec_delimiter), vec_min(_vec_min), vec_max(_vec_max), 
+            option(_str, _type, false), vec_delimiter(_vec_delimiter), vec_min(_vec_min), vec_max(_vec_max), 
             vec_def(_vec_def)
-        { num_already_initialized_elems = 0; }
+        { }
         virtual ~option_vector() {}
-        virtual void print() const {
-            parser.sout << str << ": ";
-            to_ostream(parser.sout);
-            parser.sout << std::endl;
-        }
-        virtual bool do_parse(const char *sval);
+        // parses vec_def once for all parser instances, throws logic_error if it is malformed
+        void prepare_defaults(const args_parser &p);
+        virtual bool do_parse(const args_parser &p, option_state &st, const char *sval) const;
         virtual bool is_scalar() const { return false; }
         virtual bool is_map() const { return false; }
-        virtual void to_ostream(std::ostream &s) const { for (size_t i = 0; i < val.size(); i++) { s << val[i]; if (i != val.size()) s << ", "; } }
+        virtual void to_ostream(std::ostream &s, const option_state &st) const { auto &vals = st.get_vals(); for (size_t i = 0; i < vals.size(); i++) { s << vals[i]; if (i != vals.size()) s << ", "; } }
 #ifdef WITH_YAML_CPP        
-        virtual void to_yaml(YAML::Emitter& out) const;
-        virtual void from_yaml(const YAML::Node& node);
+        virtual void to_yaml(YAML::Emitter& out, const option_state &st) const;
+        virtual void from_yaml(const YAML::Node& node, option_state &st) const;
 #endif        
-        virtual void set_default_value();
-        virtual bool is_default_setting_required() { return val.size() == 0 && !required; }
-        virtual bool is_required_but_not_set() { return required && vec_min != 0 && val.size() == 0; }
-        virtual std::vector<args_parser::value> get_value_as_vector() const { return val; }
-        virtual bool get_value_as_map(std::map<std::string, std::string> &) const { return false; }
+        virtual void set_default_value(const args_parser &p, option_state &st) const;
+        virtual void reset(option_state &st) const { st.vals.clear(); st.shared_vals.reset(); st.num_already_initialized_elems = 0; st.defaulted = false; }
+        virtual bool is_default_setting_required(const option_state &st) const { return st.get_vals().size() == 0 && !required; }
+        virtual bool is_required_but_not_set(const option_state &st) const { return required && vec_min != 0 && st.get_vals().size() == 0; }
+        virtual std::vector<args_parser::value> get_value_as_vector(const option_state &st) const { return st.get_vals(); }
+        virtual size_t get_values(const option_state &st, const args_parser::value *&first) const { first = st.get_vals().data(); return st.get_vals().size(); }
+        virtual bool get_value_as_map(const option_state &, std::map<std::string, std::string> &) const { return false; }
+        virtual void get_footprint(const option_state &st, footprint &f) const;
     };
     struct option_map : public option {
         enum { MAX_VEC_SIZE = 1024 };
         char vec_delimiter;
         char kv_delimiter = '=';
-        int num_already_initialized_elems;
-        bool map_always_override = false;
-        std::vector<args_parser::value> val;
         std::string vec_def;
-        std::map<std::string, std::string> kvmap;
-        option_map(const args_parser &_parser, const std::string &_str, char _vec_delimiter, char _kv_delimiter)  :
-            option(_parser, _str, STRING, true), vec_delimiter(_vec_delimiter), kv_delimiter(_kv_delimiter)
-        { num_already_initialized_elems = 0; }
-        option_map(const args_parser &_parser, const std::string &_str, const std::string &_vec_def, char _vec_delimiter, char _kv_delimiter)  :
-            option(_parser, _str, STRING, false), vec_delimiter(_vec_delimiter), kv_delimiter(_kv_delimiter), 
+        std::shared_ptr<const std::vector<args_parser::value>> def_vals;  // vec_def parsed by prepare_defaults()
+        std::shared_ptr<const std::map<std::string, std::string>> def_kvmap;
+        option_map(const std::string &_str, char _vec_delimiter, char _kv_delimiter)  :
+            option(_str, STRING, true), vec_delimiter(_vec_delimiter), kv_delimiter(_kv_delimiter)
+        { }
+        option_map(const std::string &_str, const std::string &_vec_def, char _vec_delimiter, char _kv_delimiter)  :
+            option(_str, STRING, false), vec_delimiter(_vec_delimiter), kv_delimiter(_kv_delimiter), 
             vec_def(_vec_def)
-        { num_already_initialized_elems = 0; }
+        { }
 
         virtual ~option_map() {}
-        virtual void print() const {
-            parser.sout << str << ": ";
-            to_ostream(parser.sout);
-            parser.sout << std::endl;
-        }
-        virtual bool do_parse(const char *sval);
+        void prepare_defaults(const args_parser &p);
+        virtual bool do_parse(const args_parser &p, option_state &st, const char *sval) const;
         virtual bool is_scalar() const { return false; }
         virtual bool is_map() const { return true; }
-        virtual void to_ostream(std::ostream &s) const { for (size_t i = 0; i < val.size(); i++) { s << val[i]; if (i != val.size()) s << ", "; } }
+        virtual void to_ostream(std::ostream &s, const option_state &st) const { auto &vals = st.get_vals(); for (size_t i = 0; i < vals.size(); i++) { s << vals[i]; if (i != vals.size()) s << ", "; } }
 #ifdef WITH_YAML_CPP        
-        virtual void to_yaml(YAML::Emitter& out) const;
-        virtual void from_yaml(const YAML::Node& node);
+        virtual void to_yaml(YAML::Emitter& out, const option_state &st) const;
+        virtual void from_yaml(const YAML::Node& node, option_state &st) const;
 #endif        
-        virtual void set_default_value();
-        virtual bool is_default_setting_required() { return val.size() == 0 && !required; }
-        virtual bool is_required_but_not_set() { return false; }
-        virtual std::vector<args_parser::value> get_value_as_vector() const { return val; }
-        virtual bool get_value_as_map(std::map<std::string, std::string> &r) const { r = kvmap; return true; }
+        virtual void set_default_value(const args_parser &p, option_state &st) const;
+        virtual void reset(option_state &st) const {
+            st.vals.clear(); st.kvmap.clear(); st.shared_vals.reset(); st.shared_kvmap.reset();
+            st.num_already_initialized_elems = 0; st.map_always_override = false; st.defaulted = false;
+        }
+        virtual bool is_default_setting_required(const option_state &st) const { return st.get_vals().size() == 0 && !required; }
+        virtual bool is_required_but_not_set(const option_state &) const { return false; }
+        virtual std::vector<args_parser::value> get_value_as_vector(const option_state &st) const { return st.get_vals(); }
+        virtual size_t get_values(const option_state &st, const args_parser::value *&first) const { first = st.get_vals().data(); return st.get_vals().size(); }
+        virtual bool get_value_as_map(const option_state &st, std::map<std::string, std::string> &r) const { r = st.get_kvmap(); return true; }
+        virtual void get_footprint(const option_state &st, footprint &f) const;
     };    
 
+    // The set of expected options with the name index. Parser instances made with
+    // get_schema() share it; once shared, no options can be added.
+    struct schema {
+        std::map<std::string, std::vector<std::shared_ptr<option>>> expected_args;
+        std::vector<const option *> option_index;  // sorted by name, no EXTRA_ARGS
+        size_t noptions = 0;
+        bool frozen = false;
+    };
+
+    // One difference between two configurations, see diff()
+    struct diff_entry {
+        enum kind_t { CHANGED, ADDED, REMOVED, DEFAULTED };
+        kind_t kind;
+        std::string group;
+        std::string name;
+        const option *left;   // NULL for ADDED
+        const option *right;  // NULL for REMOVED and when compared with YAML
+    };
+
+    // Memory report of get_footprint(): groups are keyed by name, options are
+    // in the order of groups, then in the order they were added
+    struct footprint_report {
+        footprint total;
+        std::map<std::string, footprint> groups;
+        std::vector<std::pair<std::string, footprint>> options;
+    };
+
+    // One argument set of parse_batch() and its outcome. The parser instance keeps
+    // the parsed values for get() and the other read-only calls; it owns a copy of
+    // the arguments, so items may be copied and moved freely.
+    struct batch_item {
+        std::vector<std::string> args;  // args[0] is the program name
+        size_t line = 0;                // line number for a job-array file input
+        bool result = false;
+        error_t error = NONE;
+        std::string error_option;
+        std::string error_extra;
+        std::string messages;           // the parse() output: errors or help
+        std::shared_ptr<args_parser> parser;
+    };
+
     protected:
     std::set<flag_t> flags;
     std::string current_group;
-    std::map<std::string, std::vector<std::shared_ptr<option>>> expected_args;
+    std::shared_ptr<schema> sch;
+    std::map<std::string, std::vector<std::shared_ptr<option>>> &expected_args;  // sch->expected_args
+    std::vector<option_state> states;  // indexed by option::index
+    struct batch_storage;
+    std::shared_ptr<batch_storage> storage;  // argv and sout of a parse_batch() instance live here
     std::vector<std::string> unknown_args;
-    option *prev_option;
+    const option *prev_option;
     error_t last_error;
     std::string last_error_option;
     std::string last_error_extra;
    
     bool match(const std::string &arg, const std::string &pattern) const;
-    bool match(const std::string &arg, option &exp) const;
-    bool get_value(const std::string &arg, option &exp);
-    void get_default_value(option &d);
+    bool match(const std::string &arg, const option &exp) const;
+    bool get_value(const std::string &arg, const option &exp);
+    option &add_option(const std::shared_ptr<option> &popt);
+    option_state &state(const option &opt) { return states[opt.index]; }
  
 
     void get_extra_args_num(int &num_extra_args, int &num_required_extra_args) const;
@@ -257,6 +383,11 @@ class args_parser {
     void print() const;
     void get_command_line(std::string &) const;
     bool parse();
+    // Applies option tokens (like "--opt=value" or "-opt value", depending on the delimiter)
+    // to an already parsed instance. Only the given options are reset, parsed again and
+    // re-validated; repeated tokens of a vector or map option accumulate as in parse().
+    // Option names must match exactly; extra args can't be changed this way.
+    bool apply(int ntokens, const char * const *tokens);
     template <typename T>
     option &add(const char *s);
     template <typename T>
@@ -269,6 +400,12 @@ class args_parser {
     args_parser::option &add_map(const char *s, char delim1 = ':', char delim2 = '=');
     args_parser::option &add_map(const char *s, const char *def = "", char delim1 = ':', char delim2 = '=');
 
+    // Marks the schema as shared and returns it for making more parser instances on it;
+    // from then on options can neither be added nor changed
+    std::shared_ptr<const schema> get_schema();
+    // Per-parse state of an option of this parser's schema
+    const option_state &get_state(const option &opt) const { return states[opt.index]; }
+
     args_parser &set_current_group(const std::string &g) { current_group = g; return *this; }
     args_parser &set_default_current_group() { current_group = ""; return *this; }
 
@@ -280,6 +417,9 @@ class args_parser {
     void get(const std::string &s, std::vector<T> &r) const;
     void get(const std::string &s, std::map<std::string, std::string> &r) const;
     void get_unknown_args(std::vector<std::string> &r) const;
+    // Looks up n options by name in a single pass over expected args,
+    // result[i] is set to NULL if there is no such option
+    void get_options(size_t n, const char * const *names, const option **result) const;
 
     template <typename T>
     bool parse_special(const std::string &s, T &r) const;
@@ -295,6 +435,44 @@ class args_parser {
     bool is_option(const std::string &str) const;
     bool is_option_defaulted(const std::string &str) const;
     bool is_help_mode() const;
+    // Bytes held by the parser per option, per group and in total, broken down by category.
+    // The schema part (option descriptions, pre-parsed defaults, name index) is included
+    // even if it's shared with other parser instances. Takes a single pass over the
+    // options and their values.
+    void get_footprint(footprint_report &report) const;
+    void print_footprint() const;
+    // 64-bit content hash of the effective configuration: typed values and defaulted
+    // flags of all options, extra args and unknown args. Doesn't depend on the order of
+    // options in command line or in groups; extra args and unknown args are positional.
+    // Suitable as a persistent cache key: the value is the same on any platform and
+    // with any library version of the same hash_version, and the caption, description
+    // and group of options don't affect it. hash_version is bumped whenever a change
+    // of the encoding changes the values.
+    uint64_t hash() const;
+    static const int hash_version;
+    // Typed comparison of this configuration (the left one) with another parser of the
+    // same schema. CHANGED: values differ; ADDED/REMOVED: option exists only in the
+    // right/left parser; DEFAULTED: values are equal, but only one side is defaulted.
+    // The SYS group is not compared. Entries refer to options of both parsers.
+    void diff(const args_parser &other, std::vector<diff_entry> &result) const;
+#ifdef WITH_YAML_CPP
+    // The same against the dump() output of another run: an option that is missing in
+    // the YAML text was defaulted there, so it is compared with the default value: reported
+    // as DEFAULTED if it's equal, CHANGED otherwise, and skipped if it's defaulted here too;
+    // unknown keys are ADDED. Returns false on YAML parse error.
+    bool diff(const std::string &input, std::vector<diff_entry> &result) const;
+#endif
+
+    // Parses many argument sets (without the program name) in parallel on nthreads
+    // threads, 0 means one per hardware thread. Each set gets its own parser instance
+    // on the schema of this parser, which gets shared; flags, program name and argv[0]
+    // are taken from this parser. Items are in input order; returns the number of
+    // successfully parsed sets.
+    size_t parse_batch(const std::vector<std::vector<std::string>> &argsets, std::vector<batch_item> &items,
+                       unsigned nthreads = 0);
+    // The same for a job-array file: one argument set per line, split by whitespace with
+    // single or double quotes grouping words; empty lines and '#' comments are skipped
+    size_t parse_batch(std::istream &in, std::vector<batch_item> &items, unsigned nthreads = 0);
 
     error_t get_last_error(std::string &option, std::string &extra) {
         option = last_error_option;
@@ -307,6 +485,14 @@ class args_parser {
     enum foreach_t { FOREACH_FIRST, FOREACH_NEXT };
     bool in_expected_args(enum foreach_t t, const std::string *&group, std::shared_ptr<option> *&arg);    
     bool in_expected_args(enum foreach_t t, const std::string *&group, const std::shared_ptr<option> *&arg) const;    
+    std::map<std::string, std::vector<std::shared_ptr<option>>>::iterator foreach_it;
+    size_t foreach_j = 0;
+    mutable std::map<std::string, std::vector<std::shared_ptr<option>>>::const_iterator foreach_cit;
+    mutable size_t foreach_cj = 0;
+    static bool same_value(const option &a, const option_state &as, const option &b, const option_state &bs);
+    const option *find_option(const char *name, size_t len) const;
+    void parse_batch_item(const std::shared_ptr<const schema> &shared, batch_item &item) const;
+    size_t parse_batch(std::vector<batch_item> &items, unsigned nthreads);
 };
 
 template <typename T> args_parser::arg_t get_arg_t();
@@ -325,34 +511,31 @@ void vresult_to_vector(const std::vector<args_parser::value> &in, std::vector<T>
 
 template <typename T>
 args_parser::option &args_parser::add(const char *s) {
-    std::shared_ptr<option> popt = std::make_shared<args_parser::option_scalar>(*this, s, get_arg_t<T>());
-    expected_args[current_group].push_back(popt);
-    return *popt.get();
+    std::shared_ptr<option> popt = std::make_shared<args_parser::option_scalar>(s, get_arg_t<T>());
+    return add_option(popt);
 }
 
 template <typename T>
 args_parser::option &args_parser::add(const char *s, T v) {
-    std::shared_ptr<option> popt = std::make_shared<args_parser::option_scalar>(*this, s, get_arg_t<T>(), value(v));
-    expected_args[current_group].push_back(popt);
-    return *popt.get();
+    std::shared_ptr<option> popt = std::make_shared<args_parser::option_scalar>(s, get_arg_t<T>(), value(v));
+    return add_option(popt);
 }
 
 template <typename T>
 args_parser::option &args_parser::add_vector(const char *s, char delim, int min, int max) {
     if (max > option_vector::MAX_VEC_SIZE)
         throw std::logic_error("args_parser: maximum allowed vector size for vector argument exceeded");
-    std::shared_ptr<option> popt = std::make_shared<args_parser::option_vector>(*this, s, get_arg_t<T>(), delim, min, max);
-    expected_args[current_group].push_back(popt);
-    return *popt.get();
+    std::shared_ptr<option> popt = std::make_shared<args_parser::option_vector>(s, get_arg_t<T>(), delim, min, max);
+    return add_option(popt);
 }
 
 template <typename T>
 args_parser::option &args_parser::add_vector(const char *s, const char *defaults, char delim, int min, int max) {
     if (max > option_vector::MAX_VEC_SIZE)
         throw std::logic_error("args_parser: maximum allowed vector size for vector argument exceeded");
-    std::shared_ptr<option> popt = std::make_shared<args_parser::option_vector>(*this, s, get_arg_t<T>(), delim, min, max, defaults); 
-    expected_args[current_group].push_back(popt);
-    return *popt.get();
+    std::shared_ptr<option_vector> popt = std::make_shared<args_parser::option_vector>(s, get_arg_t<T>(), delim, min, max, defaults); 
+    popt->prepare_defaults(*this);
+    return add_option(popt);
 }
 template <typename T>
 void args_parser::get(const std::string &s, std::vector<T> &r) const {
@@ -372,24 +555,24 @@ T args_parser::get(const std::string &s) const {
 template <typename T>
 bool args_parser::parse_special(const std::string &s, T &r) const {
     option_scalar d("[FREE ARG]", get_arg_t<T>());
-    bool res = d.do_parse(s.c_str());
+    option_state st;
+    bool res = d.do_parse(*this, st, s.c_str());
     if (res) {
-        r = get_val<T>(d.get_value_as_vector()[0]);
+        r = get_val<T>(st.val);
     }
     return res;
 }
 
 template <typename T>
 bool args_parser::parse_special_vec(const std::string &s, std::vector<T> &r, char delim, int min, int max) const {
-    option_vector d(*this, "[FREE ARG]", get_arg_t<T>(), delim, min, max);
-    bool res = d.do_parse(s.c_str());
+    option_vector d("[FREE ARG]", get_arg_t<T>(), delim, min, max);
+    option_state st;
+    bool res = d.do_parse(*this, st, s.c_str());
     if (res) {
-        vresult_to_vector(d.get_value_as_vector(), r);
+        vresult_to_vector(st.vals, r);
     }
     return res;
 }
 
 YAML::Emitter &operator<< (YAML::Emitter& out, const args_parser::value &v);
 void operator>> (const YAML::Node& node, args_parser::value &v);
-YAML::Emitter &operator<< (YAML::Emitter& out, const args_parser::option &opt);
-void operator>> (const YAML::Node& node, args_parser::option &opt);
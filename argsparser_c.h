@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2018-2024 Alexey V. Medvedev
+ * This code is an extension of the parts of Intel(R) MPI Benchmarks project.
+ * It keeps the same 3-Clause BSD License.
+ */
+
+/* Plain C interface to the args_parser, for C and Fortran callers.
+ * All the functions return ARGSPARSER_OK on success or one of the error codes;
+ * no C++ exceptions cross the interface. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct argsparser_handle *argsparser_t;
+
+enum argsparser_type { ARGSPARSER_INT = 0, ARGSPARSER_FLOAT, ARGSPARSER_BOOL, ARGSPARSER_STRING,
+                       ARGSPARSER_INT64, ARGSPARSER_DOUBLE };
+
+enum argsparser_status {
+    ARGSPARSER_OK = 0,
+    ARGSPARSER_ERROR,               /* parse error or an exception inside the parser */
+    ARGSPARSER_NO_SUCH_OPTION,
+    ARGSPARSER_TYPE_MISMATCH,
+    ARGSPARSER_BUFFER_TOO_SMALL,
+    ARGSPARSER_NOT_SET              /* scalar option without value */
+};
+
+/* Request for batch value export. The buffer is: int[] for ARGSPARSER_INT and ARGSPARSER_BOOL,
+ * float[] for ARGSPARSER_FLOAT, int64_t[] for ARGSPARSER_INT64, double[] for ARGSPARSER_DOUBLE,
+ * char[] for ARGSPARSER_STRING, where elements are put one after
+ * another, each terminated with '\0'. The capacity is given in elements, in bytes for strings.
+ * On return: count is the number of elements of the option value, size is the number of
+ * buffer elements (bytes for strings) which are used or, with ARGSPARSER_BUFFER_TOO_SMALL, required. */
+struct argsparser_request {
+    const char *name;
+    int type;
+    void *buf;
+    size_t capacity;
+    size_t count;
+    size_t size;
+    int status;
+};
+
+argsparser_t argsparser_create(int argc, char **argv);
+void argsparser_destroy(argsparser_t p);
+int argsparser_parse(argsparser_t p);
+
+int argsparser_add_int(argsparser_t p, const char *name);
+int argsparser_add_int_default(argsparser_t p, const char *name, int def);
+int argsparser_add_float(argsparser_t p, const char *name);
+int argsparser_add_float_default(argsparser_t p, const char *name, float def);
+int argsparser_add_int64(argsparser_t p, const char *name);
+int argsparser_add_int64_default(argsparser_t p, const char *name, int64_t def);
+int argsparser_add_double(argsparser_t p, const char *name);
+int argsparser_add_double_default(argsparser_t p, const char *name, double def);
+int argsparser_add_bool(argsparser_t p, const char *name);
+int argsparser_add_bool_default(argsparser_t p, const char *name, int def);
+int argsparser_add_string(argsparser_t p, const char *name);
+int argsparser_add_string_default(argsparser_t p, const char *name, const char *def);
+int argsparser_add_flag(argsparser_t p, const char *name);
+/* def == NULL makes the option required */
+int argsparser_add_vector(argsparser_t p, const char *name, int type, const char *def, char delim, int min, int max);
+
+int argsparser_get_int(argsparser_t p, const char *name, int *v);
+int argsparser_get_float(argsparser_t p, const char *name, float *v);
+int argsparser_get_bool(argsparser_t p, const char *name, int *v);
+int argsparser_get_int64(argsparser_t p, const char *name, int64_t *v);
+int argsparser_get_double(argsparser_t p, const char *name, double *v);
+int argsparser_get_string(argsparser_t p, const char *name, char *buf, size_t capacity);
+/* Fills in all the requests in one pass; returns ARGSPARSER_OK if each of them succeeded,
+ * otherwise the status of the first failed one */
+int argsparser_get_batch(argsparser_t p, struct argsparser_request *requests, size_t n);
+int argsparser_is_option_defaulted(argsparser_t p, const char *name, int *v);
+int argsparser_dump(argsparser_t p, char *buf, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
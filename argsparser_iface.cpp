@@ -6,6 +6,7 @@
 
 #include "argsparser.h"
 #include "argsparser_iface.h"
+#include <string.h>
 
 using namespace parser_iface;
 
@@ -55,6 +56,12 @@ namespace parser_iface {
     void parser::add_float(const std::string &s) { ((args_parser *)ptr)->add<float>(s.c_str()); }
     void parser::add_float(const std::string &s, float v) { ((args_parser *)ptr)->add<float>(s.c_str(), v); }
     float parser::get_float(const std::string &s) { return ((args_parser *)ptr)->get<float>(s); }
+    void parser::add_int64(const std::string &s) { ((args_parser *)ptr)->add<int64_t>(s.c_str()); }
+    void parser::add_int64(const std::string &s, int64_t v) { ((args_parser *)ptr)->add<int64_t>(s.c_str(), v); }
+    int64_t parser::get_int64(const std::string &s) { return ((args_parser *)ptr)->get<int64_t>(s); }
+    void parser::add_double(const std::string &s) { ((args_parser *)ptr)->add<double>(s.c_str()); }
+    void parser::add_double(const std::string &s, double v) { ((args_parser *)ptr)->add<double>(s.c_str(), v); }
+    double parser::get_double(const std::string &s) { return ((args_parser *)ptr)->get<double>(s); }
 
     void parser::add_bool_vector(const std::string &s, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<bool>(s.c_str(), delim, min, max); }
     std::vector<bool> parser::get_bool_vector(const std::string &s) { std::vector<bool> res; ((args_parser *)ptr)->get<bool>(s, res); return res; }
@@ -64,15 +71,225 @@ namespace parser_iface {
     std::vector<int> parser::get_int_vector(const std::string &s) { std::vector<int> res; ((args_parser *)ptr)->get<int>(s, res); return res; }
     void parser::add_float_vector(const std::string &s, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<float>(s.c_str(), delim, min, max); }
     std::vector<float> parser::get_float_vector(const std::string &s) { std::vector<float> res; ((args_parser *)ptr)->get<float>(s, res); return res; }
+    void parser::add_int64_vector(const std::string &s, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<int64_t>(s.c_str(), delim, min, max); }
+    std::vector<int64_t> parser::get_int64_vector(const std::string &s) { std::vector<int64_t> res; ((args_parser *)ptr)->get<int64_t>(s, res); return res; }
+    void parser::add_double_vector(const std::string &s, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<double>(s.c_str(), delim, min, max); }
+    std::vector<double> parser::get_double_vector(const std::string &s) { std::vector<double> res; ((args_parser *)ptr)->get<double>(s, res); return res; }
 
     void parser::add_bool_vector(const std::string &s, const std::string &def, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<bool>(s.c_str(), def.c_str(), delim, min, max); }
     void parser::add_string_vector(const std::string &s, const std::string &def, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<std::string>(s.c_str(), def.c_str(), delim, min, max); }
     void parser::add_int_vector(const std::string &s, const std::string &def, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<int>(s.c_str(), def.c_str(), delim, min, max); }
     void parser::add_float_vector(const std::string &s, const std::string &def, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<float>(s.c_str(), def.c_str(), delim, min, max); }
+    void parser::add_int64_vector(const std::string &s, const std::string &def, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<int64_t>(s.c_str(), def.c_str(), delim, min, max); }
+    void parser::add_double_vector(const std::string &s, const std::string &def, char delim, int min, int max) { ((args_parser *)ptr)->add_vector<double>(s.c_str(), def.c_str(), delim, min, max); }
 
 
     bool parser::load(std::istream &st) { return ((args_parser *)ptr)->load(st); }
     std::string parser::dump() { return ((args_parser *)ptr)->dump(); }
+    uint64_t parser::hash() { return ((args_parser *)ptr)->hash(); }
+
+    static int export_values(const args_parser &p, const args_parser::option *opt, parser::request &r) {
+        if (!opt)
+            return ARGSPARSER_NO_SUCH_OPTION;
+        if (opt->is_map())
+            return ARGSPARSER_TYPE_MISMATCH;
+        switch (r.type) {
+            case ARGSPARSER_INT: if (opt->type != args_parser::INT) return ARGSPARSER_TYPE_MISMATCH; break;
+            case ARGSPARSER_FLOAT: if (opt->type != args_parser::FLOAT) return ARGSPARSER_TYPE_MISMATCH; break;
+            case ARGSPARSER_BOOL: if (opt->type != args_parser::BOOL) return ARGSPARSER_TYPE_MISMATCH; break;
+            case ARGSPARSER_STRING: if (opt->type != args_parser::STRING) return ARGSPARSER_TYPE_MISMATCH; break;
+            case ARGSPARSER_INT64: if (opt->type != args_parser::INT64) return ARGSPARSER_TYPE_MISMATCH; break;
+            case ARGSPARSER_DOUBLE: if (opt->type != args_parser::DOUBLE) return ARGSPARSER_TYPE_MISMATCH; break;
+            default: return ARGSPARSER_TYPE_MISMATCH;
+        }
+        const args_parser::value *vals = NULL;
+        r.count = opt->get_values(p.get_state(*opt), vals);
+        if (opt->is_scalar() && r.count == 0)
+            return ARGSPARSER_NOT_SET;
+        if (r.type == ARGSPARSER_STRING) {
+            r.size = 0;
+            for (size_t i = 0; i < r.count; i++)
+                r.size += vals[i].str.size() + 1;
+        } else {
+            r.size = r.count;
+        }
+        if (r.size > r.capacity)
+            return ARGSPARSER_BUFFER_TOO_SMALL;
+        switch (r.type) {
+            case ARGSPARSER_INT: for (size_t i = 0; i < r.count; i++) ((int *)r.buf)[i] = vals[i].i; break;
+            case ARGSPARSER_FLOAT: for (size_t i = 0; i < r.count; i++) ((float *)r.buf)[i] = vals[i].f; break;
+            case ARGSPARSER_BOOL: for (size_t i = 0; i < r.count; i++) ((int *)r.buf)[i] = vals[i].b ? 1 : 0; break;
+            case ARGSPARSER_INT64: for (size_t i = 0; i < r.count; i++) ((int64_t *)r.buf)[i] = vals[i].i64; break;
+            case ARGSPARSER_DOUBLE: for (size_t i = 0; i < r.count; i++) ((double *)r.buf)[i] = vals[i].d; break;
+            case ARGSPARSER_STRING: {
+                char *out = (char *)r.buf;
+                for (size_t i = 0; i < r.count; i++) {
+                    memcpy(out, vals[i].str.c_str(), vals[i].str.size() + 1);
+                    out += vals[i].str.size() + 1;
+                }
+                break;
+            }
+        }
+        return ARGSPARSER_OK;
+    }
+
+    bool parser::get_batch(request *requests, size_t n) {
+        std::vector<const char *> names(n);
+        std::vector<const args_parser::option *> opts(n);
+        for (size_t i = 0; i < n; i++)
+            names[i] = requests[i].name;
+        ((args_parser *)ptr)->get_options(n, names.data(), opts.data());
+        bool ok = true;
+        for (size_t i = 0; i < n; i++) {
+            requests[i].count = requests[i].size = 0;
+            requests[i].status = export_values(*(args_parser *)ptr, opts[i], requests[i]);
+            ok = ok && (requests[i].status == ARGSPARSER_OK);
+        }
+        return ok;
+    }
+}
+
+// Plain C interface: the handle is the parser_iface::parser object itself.
+
+static parser *as_parser(argsparser_t p) { return reinterpret_cast<parser *>(p); }
+
+template <typename F>
+static int guarded(argsparser_t p, F f) {
+    if (!p)
+        return ARGSPARSER_ERROR;
+    try {
+        return f(*as_parser(p));
+    }
+    catch (...) {
+        return ARGSPARSER_ERROR;
+    }
+}
+
+static int get_scalar(argsparser_t p, const char *name, int type, void *v) {
+    argsparser_request r = { name, type, v, 1, 0, 0, ARGSPARSER_ERROR };
+    return guarded(p, [&r](parser &P) { P.get_batch(&r, 1); return r.status; });
+}
+
+extern "C" {
+
+argsparser_t argsparser_create(int argc, char **argv) {
+    try {
+        return reinterpret_cast<argsparser_t>(new parser(argc, argv));
+    }
+    catch (...) {
+        return NULL;
+    }
+}
+
+void argsparser_destroy(argsparser_t p) { delete as_parser(p); }
+
+int argsparser_parse(argsparser_t p) {
+    return guarded(p, [](parser &P) { return P.parse() ? ARGSPARSER_OK : ARGSPARSER_ERROR; });
+}
+
+int argsparser_add_int(argsparser_t p, const char *name) {
+    return guarded(p, [name](parser &P) { P.add_int(name); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_int_default(argsparser_t p, const char *name, int def) {
+    return guarded(p, [name, def](parser &P) { P.add_int(name, def); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_float(argsparser_t p, const char *name) {
+    return guarded(p, [name](parser &P) { P.add_float(name); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_float_default(argsparser_t p, const char *name, float def) {
+    return guarded(p, [name, def](parser &P) { P.add_float(name, def); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_int64(argsparser_t p, const char *name) {
+    return guarded(p, [name](parser &P) { P.add_int64(name); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_int64_default(argsparser_t p, const char *name, int64_t def) {
+    return guarded(p, [name, def](parser &P) { P.add_int64(name, def); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_double(argsparser_t p, const char *name) {
+    return guarded(p, [name](parser &P) { P.add_double(name); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_double_default(argsparser_t p, const char *name, double def) {
+    return guarded(p, [name, def](parser &P) { P.add_double(name, def); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_bool(argsparser_t p, const char *name) {
+    return guarded(p, [name](parser &P) { P.add_bool(name); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_bool_default(argsparser_t p, const char *name, int def) {
+    return guarded(p, [name, def](parser &P) { P.add_bool(name, def != 0); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_string(argsparser_t p, const char *name) {
+    return guarded(p, [name](parser &P) { P.add_string(name); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_string_default(argsparser_t p, const char *name, const char *def) {
+    return guarded(p, [name, def](parser &P) { P.add_string(name, def); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_flag(argsparser_t p, const char *name) {
+    return guarded(p, [name](parser &P) { P.add_flag(name); return ARGSPARSER_OK; });
+}
+
+int argsparser_add_vector(argsparser_t p, const char *name, int type, const char *def, char delim, int min, int max) {
+    return guarded(p, [=](parser &P) {
+        switch (type) {
+            case ARGSPARSER_INT: def ? P.add_int_vector(name, def, delim, min, max) : P.add_int_vector(name, delim, min, max); break;
+            case ARGSPARSER_FLOAT: def ? P.add_float_vector(name, def, delim, min, max) : P.add_float_vector(name, delim, min, max); break;
+            case ARGSPARSER_BOOL: def ? P.add_bool_vector(name, def, delim, min, max) : P.add_bool_vector(name, delim, min, max); break;
+            case ARGSPARSER_STRING: def ? P.add_string_vector(name, def, delim, min, max) : P.add_string_vector(name, delim, min, max); break;
+            case ARGSPARSER_INT64: def ? P.add_int64_vector(name, def, delim, min, max) : P.add_int64_vector(name, delim, min, max); break;
+            case ARGSPARSER_DOUBLE: def ? P.add_double_vector(name, def, delim, min, max) : P.add_double_vector(name, delim, min, max); break;
+            default: return (int)ARGSPARSER_TYPE_MISMATCH;
+        }
+        return (int)ARGSPARSER_OK;
+    });
+}
+
+int argsparser_get_int(argsparser_t p, const char *name, int *v) { return get_scalar(p, name, ARGSPARSER_INT, v); }
+int argsparser_get_float(argsparser_t p, const char *name, float *v) { return get_scalar(p, name, ARGSPARSER_FLOAT, v); }
+int argsparser_get_bool(argsparser_t p, const char *name, int *v) { return get_scalar(p, name, ARGSPARSER_BOOL, v); }
+int argsparser_get_int64(argsparser_t p, const char *name, int64_t *v) { return get_scalar(p, name, ARGSPARSER_INT64, v); }
+int argsparser_get_double(argsparser_t p, const char *name, double *v) { return get_scalar(p, name, ARGSPARSER_DOUBLE, v); }
+
+int argsparser_get_string(argsparser_t p, const char *name, char *buf, size_t capacity) {
+    argsparser_request r = { name, ARGSPARSER_STRING, buf, capacity, 0, 0, ARGSPARSER_ERROR };
+    return guarded(p, [&r](parser &P) { P.get_batch(&r, 1); return r.status; });
+}
+
+int argsparser_get_batch(argsparser_t p, struct argsparser_request *requests, size_t n) {
+    return guarded(p, [requests, n](parser &P) {
+        if (P.get_batch(requests, n))
+            return (int)ARGSPARSER_OK;
+        for (size_t i = 0; i < n; i++) {
+            if (requests[i].status != ARGSPARSER_OK)
+                return requests[i].status;
+        }
+        return (int)ARGSPARSER_ERROR;
+    });
+}
+
+int argsparser_is_option_defaulted(argsparser_t p, const char *name, int *v) {
+    return guarded(p, [name, v](parser &P) { *v = P.is_option_defaulted(name) ? 1 : 0; return ARGSPARSER_OK; });
+}
+
+int argsparser_dump(argsparser_t p, char *buf, size_t capacity) {
+    return guarded(p, [buf, capacity](parser &P) {
+        std::string out = P.dump();
+        if (out.size() + 1 > capacity)
+            return (int)ARGSPARSER_BUFFER_TOO_SMALL;
+        memcpy(buf, out.c_str(), out.size() + 1);
+        return (int)ARGSPARSER_OK;
+    });
+}
 
 }
 
@@ -9,7 +9,8 @@
 #include <vector>
 #include <iostream>
 #include <memory>
-
+#include <stdint.h>
+#include "argsparser_c.h"
 
 namespace parser_iface {
     struct parser
@@ -29,10 +30,16 @@ namespace parser_iface {
         int get_int(const std::string &s);
         void add_float(const std::string &s);
         float get_float(const std::string &s);
+        void add_int64(const std::string &s);
+        int64_t get_int64(const std::string &s);
+        void add_double(const std::string &s);
+        double get_double(const std::string &s);
         void add_bool(const std::string &s, bool v);
         void add_string(const std::string &s, std::string v);
         void add_int(const std::string &s, int v);
         void add_float(const std::string &s, float v);
+        void add_int64(const std::string &s, int64_t v);
+        void add_double(const std::string &s, double v);
 
         void add_flag(const std::string &s);
 
@@ -44,15 +51,27 @@ namespace parser_iface {
         std::vector<int> get_int_vector(const std::string &s);
         void add_float_vector(const std::string &s, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
         std::vector<float> get_float_vector(const std::string &s);
+        void add_int64_vector(const std::string &s, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
+        std::vector<int64_t> get_int64_vector(const std::string &s);
+        void add_double_vector(const std::string &s, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
+        std::vector<double> get_double_vector(const std::string &s);
 
         void add_bool_vector(const std::string &s, const std::string &def, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
         void add_string_vector(const std::string &s, const std::string &def, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
         void add_int_vector(const std::string &s, const std::string &def, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
         void add_float_vector(const std::string &s, const std::string &def, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
+        void add_int64_vector(const std::string &s, const std::string &def, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
+        void add_double_vector(const std::string &s, const std::string &def, char delim = ',', int min = 0, int max = MAX_VEC_SIZE);
 
         bool load(std::istream &st); 
         std::string dump(); 
         bool is_option_defaulted(const std::string &s);
+        uint64_t hash();
+
+        // Batch export: fills in the caller-provided buffers for all the requests in one
+        // pass over options. Returns true if each request got ARGSPARSER_OK status.
+        typedef argsparser_request request;
+        bool get_batch(request *requests, size_t n);
     };
 
     std::shared_ptr<parser> parser_create();
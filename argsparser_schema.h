@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018-2024 Alexey V. Medvedev
+ * This code is an extension of the parts of Intel(R) MPI Benchmarks project.
+ * It keeps the same 3-Clause BSD License.
+ */
+
+#pragma once
+
+#include "argsparser.h"
+#include <array>
+
+/*
+ * Compile-time declared option schema. The set of options is declared once as an X-macro:
+ *
+ *   #define MY_OPTIONS(X) \
+ *       X(size,    scalar, int64_t,     "size",    1024) \
+ *       X(tol,     scalar, double,      "tol",     ARGSPARSER_REQUIRED) \
+ *       X(lens,    vector, int,         "lens",    "1,2,4") \
+ *       X(verbose, flag,   bool,        "verbose", false)
+ *   ARGSPARSER_SCHEMA(my_options, MY_OPTIONS)
+ *
+ * The columns are: C++ identifier, option kind (scalar, vector or flag), element type,
+ * option name and default value: a value of the element type for scalars, a string
+ * for vectors, or ARGSPARSER_REQUIRED; the flag default is ignored. This generates the
+ * struct my_options with a typed member for each option and:
+ *
+ *   my_options::index::size             -- compile-time option index
+ *   my_options::keys::size              -- key type for args_parser_schema::get<K>(parser, handles)
+ *   my_options::declare(parser)         -- adds all the options, returns the handles array
+ *   my_options::fetch(parser, handles)  -- typed result struct, no name lookups
+ *   my_options::fetch(parser)           -- the same by option names
+ *
+ * The options are ordinary args_parser options, so run-time add()/get() calls can be mixed
+ * with the schema for dynamic options. Map options are available via the run-time API only.
+ * The handles refer to the args_parser schema, so they are valid for all the parser
+ * instances made on it with args_parser::get_schema().
+ */
+
+namespace args_parser_schema {
+
+struct required_t {};
+
+template <typename T>
+struct scalar {
+    typedef T value_type;
+    static args_parser::option &declare(args_parser &p, const char *name, required_t) { return p.add<T>(name); }
+    static args_parser::option &declare(args_parser &p, const char *name, const T &def) { return p.add<T>(name, def); }
+    static void fetch(const args_parser &p, const args_parser::option &opt, value_type &r) {
+        const args_parser::value *v = NULL;
+        if (opt.type != get_arg_t<T>() || opt.get_values(p.get_state(opt), v) != 1)
+            throw std::logic_error("args_parser: type mismatch or no value for option: " + opt.str);
+        r = get_val<T>(*v);
+    }
+    static void fetch(const args_parser &p, const char *name, value_type &r) { r = p.get<T>(name); }
+};
+
+template <typename T>
+struct vector {
+    typedef std::vector<T> value_type;
+    static args_parser::option &declare(args_parser &p, const char *name, required_t) { return p.add_vector<T>(name); }
+    static args_parser::option &declare(args_parser &p, const char *name, const char *def) { return p.add_vector<T>(name, def); }
+    static void fetch(const args_parser &p, const args_parser::option &opt, value_type &r) {
+        const args_parser::value *v = NULL;
+        size_t n = opt.get_values(p.get_state(opt), v);
+        if (opt.type != get_arg_t<T>() || opt.is_scalar() || opt.is_map())
+            throw std::logic_error("args_parser: type mismatch for option: " + opt.str);
+        r.clear();
+        r.reserve(n);
+        for (size_t i = 0; i < n; i++)
+            r.push_back(get_val<T>(v[i]));
+    }
+    static void fetch(const args_parser &p, const char *name, value_type &r) { r.clear(); p.get<T>(name, r); }
+};
+
+template <typename T>
+struct flag : public scalar<T> {
+    static_assert(std::is_same<T, bool>::value, "args_parser_schema: flag options must be of bool type");
+    template <typename D>
+    static args_parser::option &declare(args_parser &p, const char *name, const D &) { return p.add_flag(name); }
+};
+
+template <class K, size_t N>
+typename K::value_type get(const args_parser &p, const std::array<const args_parser::option *, N> &h) {
+    typename K::value_type r;
+    K::kind_t::fetch(p, *std::get<K::id>(h), r);
+    return r;
+}
+
+}
+
+#define ARGSPARSER_REQUIRED args_parser_schema::required_t()
+
+#define ARGSPARSER_SCHEMA_ID(ident, kind, type, name, def) ident,
+
+#define ARGSPARSER_SCHEMA_MEMBER(ident, kind, type, name, def) args_parser_schema::kind<type>::value_type ident;
+
+#define ARGSPARSER_SCHEMA_KEY(ident, kind, type, name, def) \
+    struct ident { \
+        typedef args_parser_schema::kind<type> kind_t; \
+        typedef kind_t::value_type value_type; \
+        static constexpr unsigned id = index::ident; \
+        static const char *name_str() { return name; } \
+    };
+
+#define ARGSPARSER_SCHEMA_DECLARE(ident, kind, type, name, def) \
+    h[index::ident] = &args_parser_schema::kind<type>::declare(p, name, def);
+
+#define ARGSPARSER_SCHEMA_FETCH(ident, kind, type, name, def) \
+    args_parser_schema::kind<type>::fetch(p, *h[index::ident], r.ident);
+
+#define ARGSPARSER_SCHEMA_FETCH_BY_NAME(ident, kind, type, name, def) \
+    args_parser_schema::kind<type>::fetch(p, name, r.ident);
+
+#define ARGSPARSER_SCHEMA(schema_name, ITEMS) \
+    struct schema_name { \
+        struct index { enum : unsigned { ITEMS(ARGSPARSER_SCHEMA_ID) noptions }; }; \
+        struct keys { ITEMS(ARGSPARSER_SCHEMA_KEY) }; \
+        typedef std::array<const args_parser::option *, index::noptions> handles_t; \
+        ITEMS(ARGSPARSER_SCHEMA_MEMBER) \
+        static handles_t declare(args_parser &p) { \
+            handles_t h; \
+            ITEMS(ARGSPARSER_SCHEMA_DECLARE) \
+            return h; \
+        } \
+        static schema_name fetch(const args_parser &p, const handles_t &h) { \
+            schema_name r; \
+            ITEMS(ARGSPARSER_SCHEMA_FETCH) \
+            return r; \
+        } \
+        static schema_name fetch(const args_parser &p) { \
+            schema_name r; \
+            ITEMS(ARGSPARSER_SCHEMA_FETCH_BY_NAME) \
+            return r; \
+        } \
+    };
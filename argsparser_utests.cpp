@@ -14,6 +14,9 @@
 */
 
 #include "argsparser.h"
+#include "argsparser_iface.h"
+#include "argsparser_c.h"
+#include "argsparser_schema.h"
 
 #ifdef WITH_YAML_CPP
 #include "yaml-cpp/yaml.h"
@@ -29,6 +32,7 @@
 #include <algorithm>
 #include <functional>
 #include <numeric>
+#include <type_traits>
 
 //-- UNIT TESTS ----------------------------------------------------------------------------------
 
@@ -540,6 +544,617 @@ void check_extra_args() {
     }
 }
 
+void check_batch() {
+    const char *argv[] = { "check", "--count=5", "--x=2.5", "--v=1,2,3", "--names=aa,b,cccc", "--on" };
+    {
+        parser_iface::parser p(6, (char **)argv);
+        p.add_int("count");
+        p.add_float("x");
+        p.add_int_vector("v");
+        p.add_string_vector("names");
+        p.add_flag("on");
+        p.add_bool_vector("bits", "true,false");
+        p.add_string("missing", "dflt");
+        assert(p.parse());
+        int count = 0, v[4] = {}, on = 0, bits[2] = {}, small[2] = {};
+        float x = 0;
+        char names[16], missing[16];
+        parser_iface::parser::request r[] = {
+            { "v", ARGSPARSER_INT, v, 4, 0, 0, 0 },
+            { "count", ARGSPARSER_INT, &count, 1, 0, 0, 0 },
+            { "x", ARGSPARSER_FLOAT, &x, 1, 0, 0, 0 },
+            { "names", ARGSPARSER_STRING, names, sizeof(names), 0, 0, 0 },
+            { "on", ARGSPARSER_BOOL, &on, 1, 0, 0, 0 },
+            { "bits", ARGSPARSER_BOOL, bits, 2, 0, 0, 0 },
+            { "missing", ARGSPARSER_STRING, missing, sizeof(missing), 0, 0, 0 },
+            { "count", ARGSPARSER_INT, &count, 1, 0, 0, 0 },
+        };
+        assert(p.get_batch(r, sizeof(r) / sizeof(r[0])));
+        assert(count == 5 && x == 2.5 && on == 1);
+        assert(r[0].count == 3 && v[0] == 1 && v[1] == 2 && v[2] == 3);
+        assert(r[3].count == 3 && r[3].size == 10 && std::string(names) == "aa" &&
+               std::string(names + 3) == "b" && std::string(names + 5) == "cccc");
+        assert(r[5].count == 2 && bits[0] == 1 && bits[1] == 0);
+        assert(std::string(missing) == "dflt");
+        parser_iface::parser::request e[] = {
+            { "nosuch", ARGSPARSER_INT, &count, 1, 0, 0, 0 },
+            { "x", ARGSPARSER_INT, &count, 1, 0, 0, 0 },
+            { "v", ARGSPARSER_INT, small, 2, 0, 0, 0 },
+            { "count", ARGSPARSER_INT, &count, 1, 0, 0, 0 },
+        };
+        assert(!p.get_batch(e, 4));
+        assert(e[0].status == ARGSPARSER_NO_SUCH_OPTION);
+        assert(e[1].status == ARGSPARSER_TYPE_MISMATCH);
+        assert(e[2].status == ARGSPARSER_BUFFER_TOO_SMALL && e[2].size == 3 && small[0] == 0);
+        assert(e[3].status == ARGSPARSER_OK && count == 5);
+    }
+    {
+        argsparser_t p = argsparser_create(6, (char **)argv);
+        assert(p);
+        assert(argsparser_add_int(p, "count") == ARGSPARSER_OK);
+        assert(argsparser_add_float_default(p, "x", 1.0) == ARGSPARSER_OK);
+        assert(argsparser_add_vector(p, "v", ARGSPARSER_INT, NULL, ',', 0, 16) == ARGSPARSER_OK);
+        assert(argsparser_add_vector(p, "names", ARGSPARSER_STRING, "", ',', 0, 16) == ARGSPARSER_OK);
+        assert(argsparser_add_flag(p, "on") == ARGSPARSER_OK);
+        assert(argsparser_add_int_default(p, "k", 7) == ARGSPARSER_OK);
+        assert(argsparser_parse(p) == ARGSPARSER_OK);
+        int count = 0, on = 0, k = 0, defaulted = 0;
+        float x = 0;
+        char str[4];
+        assert(argsparser_get_int(p, "count", &count) == ARGSPARSER_OK && count == 5);
+        assert(argsparser_get_float(p, "x", &x) == ARGSPARSER_OK && x == 2.5);
+        assert(argsparser_get_bool(p, "on", &on) == ARGSPARSER_OK && on == 1);
+        assert(argsparser_get_int(p, "k", &k) == ARGSPARSER_OK && k == 7);
+        assert(argsparser_is_option_defaulted(p, "k", &defaulted) == ARGSPARSER_OK && defaulted == 1);
+        assert(argsparser_get_string(p, "names", str, sizeof(str)) == ARGSPARSER_BUFFER_TOO_SMALL);
+        assert(argsparser_get_float(p, "count", &x) == ARGSPARSER_TYPE_MISMATCH);
+        assert(argsparser_get_int(p, "nosuch", &count) == ARGSPARSER_NO_SUCH_OPTION);
+        char dump[1024];
+        assert(argsparser_dump(p, dump, sizeof(dump)) == ARGSPARSER_OK && strstr(dump, "names"));
+        assert(argsparser_dump(p, dump, 4) == ARGSPARSER_BUFFER_TOO_SMALL);
+        argsparser_destroy(p);
+    }
+}
+
+void check_hash() {
+    const char *argv1[] = { "check", "--alpha=5", "--beta=1,2", "--gamma=x=1:y=2", "aaa", "bbb" };
+    const char *argv2[] = { "check", "aaa", "--gamma=x=1:y=2", "--beta=1,2", "bbb", "--alpha=5" };
+    auto make = [](int argc, const char **argv, bool reverse_groups) {
+        auto p = std::make_shared<args_parser>(argc, argv, "--", '=', std::cout);
+        p->set_flag(args_parser::ALLOW_UNEXPECTED_ARGS);
+        if (reverse_groups) {
+            p->set_current_group("ZZZ");
+            p->add_map("gamma", "", ':');
+            p->set_default_current_group();
+            p->add_vector<int>("beta", "");
+            p->add<int>("alpha", 1);
+            p->add<float>("delta", 0.5);
+        } else {
+            p->add<float>("delta", 0.5);
+            p->add<int>("alpha", 1);
+            p->add_vector<int>("beta", "");
+            p->set_current_group("AAA");
+            p->add_map("gamma", "", ':');
+            p->set_default_current_group();
+        }
+        assert(p->parse());
+        return p;
+    };
+    uint64_t h = make(6, argv1, false)->hash();
+    // pinned: the value changes only with args_parser::hash_version
+    assert(args_parser::hash_version == 2 && h == 0x1ce257db1881c6e1ULL);
+    assert(h == make(6, argv1, false)->hash());
+    assert(h == make(6, argv1, true)->hash());
+    assert(h == make(6, argv2, true)->hash());
+    // unknown args are positional
+    argv2[1] = "bbb";
+    argv2[4] = "aaa";
+    assert(h != make(6, argv2, true)->hash());
+    const char *argv3[] = { "check", "--alpha=5", "--beta=2,1", "--gamma=x=1:y=2", "aaa", "bbb" };
+    assert(h != make(6, argv3, false)->hash());
+    // the same value given explicitly is not the same as the defaulted one
+    const char *argv4[] = { "check", "--alpha=5", "--beta=1,2", "--gamma=x=1:y=2", "--delta=0.5", "aaa", "bbb" };
+    assert(h != make(7, argv4, false)->hash());
+    const char *argv5[] = { "check", "--alpha=5", "--beta=1,2", "--gamma=x=1:y=2", "aaa" };
+    assert(h != make(5, argv5, false)->hash());
+    // a map is hashed by its content, not by the order of its items
+    const char *argv6[] = { "check", "--alpha=5", "--beta=1,2", "--gamma=y=2:x=1", "aaa", "bbb" };
+    assert(h == make(6, argv6, false)->hash());
+#ifdef WITH_YAML_CPP
+    // maps loaded from YAML
+    const char *argv7[] = { "check" };
+    auto y1 = make(1, argv7, false), y2 = make(1, argv7, false), y3 = make(1, argv7, false);
+    assert(y1->load("gamma: {x: 1}") && y2->load("gamma: {x: 2}") && y3->load("gamma: {x: 1}"));
+    assert(y1->hash() != y2->hash() && y1->hash() == y3->hash());
+#endif
+}
+
+void check_diff() {
+    auto make = [](int argc, const char **argv, bool extra) {
+        auto p = std::make_shared<args_parser>(argc, argv, "--", '=', std::cout);
+        p->add<int>("alpha", 1);
+        p->add_vector<float>("beta", "1.5,2.5");
+        p->add_map("gamma", "x=1", ':');
+        p->add<std::string>("delta", "aaa");
+        if (extra)
+            p->add<bool>("epsilon", false);
+        assert(p->parse());
+        return p;
+    };
+    auto find = [](const std::vector<args_parser::diff_entry> &d, const std::string &name) {
+        for (auto &e : d)
+            if (e.name == name)
+                return (int)e.kind;
+        return -1;
+    };
+    const char *argv1[] = { "check", "--alpha=5", "--beta=1.5,2.5", "--gamma=x=1:y=2" };
+    const char *argv2[] = { "check", "--alpha=6", "--gamma=x=1:y=2", "--delta=bbb" };
+    std::vector<args_parser::diff_entry> d;
+    auto p1 = make(4, argv1, false);
+    p1->diff(*make(4, argv1, false), d);
+    assert(d.size() == 0);
+    // entries refer to the options of both parsers
+    auto p2 = make(4, argv2, true);
+    p1->diff(*p2, d);
+    assert(d.size() == 4);
+    assert(find(d, "alpha") == args_parser::diff_entry::CHANGED);
+    assert(find(d, "beta") == args_parser::diff_entry::DEFAULTED);
+    assert(find(d, "gamma") == -1);
+    assert(find(d, "delta") == args_parser::diff_entry::CHANGED);
+    assert(find(d, "epsilon") == args_parser::diff_entry::ADDED);
+    for (auto &e : d) {
+        if (e.name == "alpha")
+            assert(p1->get_state(*e.left).vals.size() == 0 && p1->get_state(*e.left).val.i == 5 &&
+                   p2->get_state(*e.right).val.i == 6);
+    }
+    p2->diff(*p1, d);
+    assert(d.size() == 4 && find(d, "epsilon") == args_parser::diff_entry::REMOVED);
+
+    std::string dumped = make(4, argv2, false)->dump();
+    assert(p1->diff(dumped, d));
+    assert(d.size() == 3);
+    assert(find(d, "alpha") == args_parser::diff_entry::CHANGED);
+    assert(find(d, "beta") == args_parser::diff_entry::DEFAULTED);
+    assert(find(d, "delta") == args_parser::diff_entry::CHANGED);
+    // options missing in the YAML text are compared with their defaults,
+    // the same as against the parser of that run
+    const char *argv0[] = { "check" };
+    for (int yaml = 0; yaml < 2; yaml++) {
+        if (yaml)
+            assert(p1->diff(make(1, argv0, false)->dump(), d));
+        else
+            p1->diff(*make(1, argv0, false), d);
+        assert(d.size() == 3);
+        assert(find(d, "alpha") == args_parser::diff_entry::CHANGED);
+        assert(find(d, "beta") == args_parser::diff_entry::DEFAULTED);
+        assert(find(d, "gamma") == args_parser::diff_entry::CHANGED);
+    }
+    assert(p1->diff(p1->dump(), d) && d.size() == 0);
+    assert(p1->diff(p1->dump() + "zeta: 1\n", d) && d.size() == 1 && d[0].kind == args_parser::diff_entry::ADDED);
+}
+
+void check_int64_suffixes() {
+    struct { const char *str; bool ok; int64_t val; } cases[] = {
+        { "0", true, 0 }, { "-17", true, -17 }, { "8K", true, 8192 }, { "8Ki", true, 8192 },
+        { "3M", true, 3LL << 20 }, { "3Mi", true, 3LL << 20 }, { "4G", true, 4LL << 30 },
+        { "4Gi", true, 4LL << 30 }, { "2T", true, 2LL << 40 }, { "2Ti", true, 2LL << 40 },
+        { "-1Ki", true, -1024 }, { "9223372036854775807", true, INT64_MAX },
+        { "9223372036854775808", false, 0 }, { "8388608Ti", false, 0 }, { "8388608T", false, 0 }, { "1k", false, 0 },
+        { "1KiB", false, 0 }, { "", false, 0 }, { "Ki", false, 0 }, { "1.5G", false, 0 }
+    };
+    for (auto &c : cases) {
+        args_parser::value v;
+        assert(v.parse(c.str, args_parser::INT64) == c.ok);
+        if (c.ok)
+            assert(v.i64 == c.val);
+    }
+    args_parser::value d;
+    assert(d.parse("0.1", args_parser::DOUBLE) && d.d == 0.1);
+    const char *argv[] = { "check", "--size=6Gi", "--tol=1e-12", "--msglens=1K,2Mi" };
+    args_parser p(4, argv, "--", '=', std::cout);
+    p.add<int64_t>("size");
+    p.add<double>("tol");
+    p.add_vector<int64_t>("msglens");
+    p.add<int64_t>("limit", 1LL << 33);
+    assert(p.parse());
+    assert(p.get<int64_t>("size") == 6LL << 30);
+    assert(p.get<double>("tol") == 1e-12);
+    std::vector<int64_t> sizes;
+    p.get<int64_t>("msglens", sizes);
+    assert(sizes.size() == 2 && sizes[0] == 1024 && sizes[1] == 2LL << 20);
+    bool mismatch = false;
+    try {
+        p.get<int>("size");
+    }
+    catch (std::logic_error &) {
+        mismatch = true;
+    }
+    assert(mismatch);
+    args_parser q(1, argv, "--", '=', std::cout);
+    q.add<int64_t>("size");
+    q.add<double>("tol");
+    q.add_vector<int64_t>("msglens");
+    q.add<int64_t>("limit", 1LL << 33);
+    assert(q.load(p.dump()));
+    assert(q.parse());
+    assert(q.get<int64_t>("size") == 6LL << 30);
+    assert(q.get<double>("tol") == 1e-12);
+    std::vector<args_parser::diff_entry> d2;
+    p.diff(q, d2);
+    assert(d2.size() == 0 && p.hash() == q.hash());
+    // suffixes are allowed in YAML input too
+    args_parser y(1, argv, "--", '=', std::cout);
+    y.add<int64_t>("size");
+    assert(y.load("size: 3Ki\n") && y.parse() && y.get<int64_t>("size") == 3072);
+    parser_iface::parser i(4, (char **)argv);
+    i.add_int64("size");
+    i.add_double("tol");
+    i.add_int64_vector("msglens");
+    assert(i.parse());
+    assert(i.get_int64("size") == 6LL << 30 && i.get_double("tol") == 1e-12);
+    int64_t buf[2];
+    parser_iface::parser::request r = { "msglens", ARGSPARSER_INT64, buf, 2, 0, 0, 0 };
+    assert(i.get_batch(&r, 1) && buf[1] == 2LL << 20);
+}
+
+#define CHECK_OPTIONS(X) \
+    X(size,    scalar, int64_t,     "size",    1024) \
+    X(tol,     scalar, double,      "tol",     ARGSPARSER_REQUIRED) \
+    X(mode,    scalar, std::string, "mode",    "fast") \
+    X(lens,    vector, int,         "lens",    "1,2,4") \
+    X(weights, vector, float,       "weights", ARGSPARSER_REQUIRED) \
+    X(verbose, flag,   bool,        "verbose", false)
+ARGSPARSER_SCHEMA(check_options, CHECK_OPTIONS)
+
+void check_schema() {
+    static_assert(check_options::index::noptions == 6, "wrong number of options");
+    static_assert(check_options::keys::lens::id == check_options::index::lens, "wrong key id");
+    static_assert(std::is_same<check_options::keys::size::value_type, int64_t>::value, "wrong key type");
+    static_assert(std::is_same<decltype(check_options::weights), std::vector<float>>::value, "wrong member type");
+    const char *argv[] = { "check", "--tol=1e-9", "--weights=0.5,0.25", "--verbose", "--extra=7" };
+    args_parser p(5, argv, "--", '=', std::cout);
+    auto handles = check_options::declare(p);
+    // run-time declared options live together with the schema
+    p.add<int>("extra", 0);
+    assert(p.parse());
+    for (auto &opts : { check_options::fetch(p, handles), check_options::fetch(p) }) {
+        assert(opts.size == 1024 && opts.tol == 1e-9 && opts.mode == "fast" && opts.verbose);
+        assert(opts.lens.size() == 3 && opts.lens[2] == 4);
+        assert(opts.weights.size() == 2 && opts.weights[1] == 0.25);
+    }
+    assert(args_parser_schema::get<check_options::keys::weights>(p, handles)[0] == 0.5);
+    assert(args_parser_schema::get<check_options::keys::mode>(p, handles) == "fast");
+    assert(p.get<int>("extra") == 7);
+    bool except = false;
+    try {
+        std::vector<int> ints;
+        args_parser_schema::vector<int>::fetch(p, *handles[check_options::index::weights], ints);
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except);
+}
+
+void check_apply() {
+    auto declare = [](args_parser &p) {
+        p.add<int>("count", 1);
+        p.add<int>("width", 2);
+        p.add_vector<int>("lens", "1,2,3");
+        p.add_map("opts", "x=1", ':');
+        p.add<std::string>("name");
+        p.add_flag("verbose");
+        p.set_flag(args_parser::SILENT);
+    };
+    const char *argv[] = { "check", "--name=aaa", "--lens=5", "--width=7" };
+    args_parser p(4, argv, "--", '=', std::cout);
+    declare(p);
+    assert(p.parse());
+    std::vector<int> lens;
+    p.get<int>("lens", lens);
+    assert(lens.size() == 3 && lens[0] == 5 && lens[2] == 3);
+    bool except = false;
+    try {
+        args_parser q(4, argv, "--", '=', std::cout);
+        q.apply(0, NULL);
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except);
+
+    const char *delta1[] = { "--count=10", "--lens=7", "--lens=8,9,10,11", "--opts=y=2", "--verbose" };
+    assert(p.apply(5, delta1));
+    assert(p.get<int>("count") == 10 && !p.is_option_defaulted("count"));
+    assert(p.get<int>("width") == 7 && p.get<std::string>("name") == "aaa");
+    lens.clear();
+    p.get<int>("lens", lens);
+    assert(lens.size() == 5 && lens[0] == 7 && lens[1] == 8 && lens[4] == 11);
+    std::map<std::string, std::string> opts;
+    p.get("opts", opts);
+    assert(opts.size() == 2 && opts["x"] == "1" && opts["y"] == "2");
+    assert(p.get<bool>("verbose"));
+
+    // the result is the same as from parsing the merged command line
+    const char *merged[] = { "check", "--name=aaa", "--width=7", "--count=10", "--lens=7", "--lens=8,9,10,11",
+                             "--opts=y=2", "--verbose" };
+    args_parser r(8, merged, "--", '=', std::cout);
+    declare(r);
+    assert(r.parse());
+    std::vector<args_parser::diff_entry> d;
+    p.diff(r, d);
+    assert(d.size() == 0 && p.hash() == r.hash());
+
+    const char *delta2[] = { "--lens=", "--count=x", "--nosuch=1", "--coun=5" };
+    assert(!p.apply(4, delta2));
+    std::string option, extra;
+    assert(p.get_last_error(option, extra) == args_parser::UNKNOWN_OPTION && option == "--coun=5");
+    lens.clear();
+    p.get<int>("lens", lens);
+    assert(lens.size() == 3 && lens[0] == 1);
+    assert(p.get<int>("width") == 7);
+
+    const char *sargv[] = { "check", "-count", "3", "-name", "bbb" };
+    args_parser s(5, sargv, "-", ' ', std::cout);
+    declare(s);
+    assert(s.parse() && s.get<int>("count") == 3);
+    const char *delta3[] = { "-width", "4", "-count" };
+    assert(!s.apply(3, delta3));
+    assert(s.get<int>("width") == 4);
+}
+
+void check_shared_schema() {
+    const char *argv0[] = { "check" };
+    args_parser proto(1, argv0, "--", '=', std::cout);
+    proto.add<int>("count", 1);
+    proto.add_vector<int>("lens", "1,2,3");
+    proto.add_map("opts", "x=1", ':');
+    args_parser::option &name = proto.add<std::string>("name");
+    proto.set_current_group("EXTRA_ARGS");
+    proto.add<int>("num", 0);
+    proto.set_default_current_group();
+    auto sch = proto.get_schema();
+    // copies would share the schema but not the option states
+    static_assert(!std::is_copy_constructible<args_parser>::value, "args_parser must not be copyable");
+    // no options can be added or changed once the schema is shared
+    bool except = false;
+    try {
+        proto.add<int>("more", 0);
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except);
+    except = false;
+    try {
+        proto.set_caption(0, "NUM");
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except);
+    except = false;
+    try {
+        name.set_description("the name");
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except && name.description == "");
+
+    const char *argv1[] = { "check", "--name=aaa", "--lens=5", "3" };
+    const char *argv2[] = { "check", "--name=bbb", "--count=7", "--opts=y=2" };
+    const char *argv3[] = { "check", "--count=x" };
+    std::vector<std::shared_ptr<args_parser>> ps;
+    for (int i = 0; i < 8; i++) {
+        const char **argv = (i % 3 == 0 ? argv1 : (i % 3 == 1 ? argv2 : argv3));
+        int argc = (i % 3 == 0 ? 4 : (i % 3 == 1 ? 4 : 2));
+        ps.push_back(std::make_shared<args_parser>(sch, argc, argv, "--", '=', std::cout));
+        ps.back()->set_flag(args_parser::SILENT);
+    }
+    for (size_t i = 0; i < ps.size(); i++)
+        assert(ps[i]->parse() == (i % 3 != 2));
+    for (size_t i = 0; i < ps.size(); i += 3) {
+        args_parser &p = *ps[i];
+        std::vector<int> lens;
+        p.get<int>("lens", lens);
+        assert(lens.size() == 3 && lens[0] == 5 && lens[1] == 2);
+        assert(p.get<std::string>("name") == "aaa" && p.get<int>("num") == 3);
+        assert(p.get<int>("count") == 1 && p.is_option_defaulted("count"));
+        std::map<std::string, std::string> opts;
+        p.get("opts", opts);
+        assert(opts.size() == 1 && opts["x"] == "1");
+    }
+    for (size_t i = 1; i < ps.size(); i += 3) {
+        args_parser &p = *ps[i];
+        assert(p.get<std::string>("name") == "bbb" && p.get<int>("count") == 7);
+        assert(p.get<int>("num") == 0 && p.is_option_defaulted("lens"));
+        std::map<std::string, std::string> opts;
+        p.get("opts", opts);
+        assert(opts["x"] == "1" && opts["y"] == "2");
+        assert(p.hash() == ps[1]->hash() && p.hash() != ps[0]->hash());
+    }
+    // instances of the same schema are compared pairwise
+    std::vector<args_parser::diff_entry> d;
+    ps[0]->diff(*ps[3], d);
+    assert(d.size() == 0);
+    ps[0]->diff(*ps[1], d);
+    assert(d.size() == 5);
+    // apply() changes only its own instance
+    const char *delta[] = { "--count=3" };
+    assert(ps[2]->apply(1, delta) && ps[2]->get<int>("count") == 3);
+    assert(ps[5]->get<int>("count") != 3 && ps[1]->get<int>("count") == 7);
+}
+
+void check_parse_batch() {
+    const char *argv[] = { "check" };
+    args_parser proto(1, argv, "--", '=', std::cout);
+    proto.add<int>("count", 1);
+    proto.add_vector<int>("lens", "1,2,3");
+    proto.add<std::string>("name");
+    proto.set_current_group("EXTRA_ARGS");
+    proto.add<int>("num", 0);
+    proto.set_default_current_group();
+    std::vector<std::vector<std::string>> argsets;
+    for (int i = 0; i < 500; i++) {
+        std::vector<std::string> args;
+        args.push_back("--name=n" + std::to_string(i));
+        if (i % 7 == 0)
+            args.push_back("--count=bad");
+        else
+            args.push_back("--count=" + std::to_string(i));
+        args.push_back(std::to_string(i * 2));
+        argsets.push_back(args);
+    }
+    std::vector<args_parser::batch_item> items;
+    assert(proto.parse_batch(argsets, items, 4) == 500 - 72);
+    assert(items.size() == 500);
+    for (int i = 0; i < 500; i++) {
+        const args_parser::batch_item &item = items[i];
+        assert(item.args.size() == 4 && item.args[0] == "check");
+        if (i % 7 == 0) {
+            assert(!item.result && item.error == args_parser::PARSE_ERROR_OPTION && item.error_option == "count");
+            assert(item.messages.find("ERROR") != std::string::npos);
+            continue;
+        }
+        assert(item.result && item.error == args_parser::NONE && item.messages == "");
+        assert(item.parser->get<int>("count") == i && item.parser->get<int>("num") == i * 2);
+        assert(item.parser->get<std::string>("name") == "n" + std::to_string(i));
+        assert(item.parser->is_option_defaulted("lens"));
+    }
+    // the same with a job-array file, results are the same with any number of threads
+    std::stringstream file;
+    file << "# job array" << std::endl
+         << "--name='a b' --count=5 7" << std::endl
+         << std::endl
+         << "  --count=6 --name=\"c d\"" << std::endl
+         << "--name=x --lens=1,2,3,4,5,6 --unknown" << std::endl;
+    for (unsigned nthreads : { 0, 1, 8 }) {
+        std::stringstream in(file.str());
+        assert(proto.parse_batch(in, items, nthreads) == 2);
+        assert(items.size() == 3);
+        assert(items[0].line == 2 && items[1].line == 4 && items[2].line == 5);
+        assert(items[0].parser->get<std::string>("name") == "a b" && items[0].parser->get<int>("num") == 7);
+        assert(items[1].parser->get<std::string>("name") == "c d" && items[1].parser->get<int>("count") == 6);
+        assert(!items[2].result && items[2].error == args_parser::UNKNOWN_EXTRA_ARGS);
+    }
+    // an item outlives the vector it came from: its parser owns the arguments and the output
+    args_parser::batch_item kept = items[1];
+    items.clear();
+    items.shrink_to_fit();
+    kept.parser->print();
+    assert(kept.parser->get<std::string>("name") == "c d" && kept.parser->get<int>("count") == 6);
+}
+
+void check_preparsed_defaults() {
+    const char *argv[] = { "check", "--lens=7" };
+    args_parser proto(1, argv, "--", '=', std::cout);
+    // malformed defaults are caught at registration
+    bool except = false;
+    try {
+        proto.add_vector<int>("bad", "1,x,3");
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except);
+    except = false;
+    try {
+        proto.add_vector<int>("short", "1", ',', 2, 4);
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except);
+    except = false;
+    try {
+        proto.add_map("badmap", "x=1:y", ':');
+    }
+    catch (std::logic_error &) {
+        except = true;
+    }
+    assert(except);
+    const args_parser::option &lens = proto.add_vector<int>("lens", "1,2,3");
+    const args_parser::option &sizes = proto.add_vector<int>("msglens", "4,5");
+    const args_parser::option &opts = proto.add_map("opts", "x=1:y=2", ':');
+    auto sch = proto.get_schema();
+    args_parser p1(sch, 1, argv, "--", '=', std::cout), p2(sch, 2, argv, "--", '=', std::cout);
+    assert(p1.parse() && p2.parse());
+    // the applied defaults refer to the same pre-parsed values
+    assert(p1.get_state(sizes).shared_vals && p1.get_state(sizes).shared_vals == p2.get_state(sizes).shared_vals);
+    assert(p1.get_state(opts).shared_kvmap == p2.get_state(opts).shared_kvmap);
+    std::vector<int> v;
+    p2.get<int>("msglens", v);
+    assert(v.size() == 2 && v[0] == 4 && v[1] == 5);
+    // and are copied on the first change
+    assert(p1.get_state(lens).shared_vals && !p2.get_state(lens).shared_vals);
+    v.clear();
+    p2.get<int>("lens", v);
+    assert(v.size() == 3 && v[0] == 7 && v[2] == 3);
+    v.clear();
+    p1.get<int>("lens", v);
+    assert(v.size() == 3 && v[0] == 1);
+    const char *delta[] = { "--opts=x=5" };
+    assert(p2.apply(1, delta));
+    std::map<std::string, std::string> m1, m2;
+    p1.get("opts", m1);
+    p2.get("opts", m2);
+    assert(m1.size() == 2 && m1["x"] == "1" && m2["x"] == "5" && m2["y"] == "2");
+    assert(p1.is_option_defaulted("opts") && !p2.is_option_defaulted("opts"));
+}
+
+void check_footprint() {
+    typedef args_parser::footprint footprint;
+    auto make = [](int argc, const char **argv) {
+        auto p = std::make_shared<args_parser>(argc, argv, "--", '=', std::cout);
+        p->add<int>("count", 1).set_description(std::string(1000, 'd'));
+        p->add_vector<int>("lens", "1,2,3");
+        p->set_current_group("extra");
+        p->add_map("opts", "x=1", ':');
+        p->set_default_current_group();
+        p->set_flag(args_parser::ALLOW_UNEXPECTED_ARGS);
+        return p;
+    };
+    std::string big_map;
+    for (int i = 0; i < 500; i++)
+        big_map += (i ? ":" : "") + std::string("key_of_some_length_") + std::to_string(i) + "=value_" + std::to_string(i);
+    big_map = "--opts=" + big_map;
+    const char *argv1[] = { "check", "--lens=5,6", "unknown" };
+    const char *argv2[] = { "check", "--lens=5,6", "unknown", big_map.c_str() };
+    auto p1 = make(3, argv1), p2 = make(4, argv2);
+    assert(p1->parse() && p2->parse());
+    args_parser::footprint_report r1, r2;
+    p1->get_footprint(r1);
+    p2->get_footprint(r2);
+    // groups add up to the total, options add up to their groups
+    footprint sum, opts;
+    for (auto &g : r1.groups)
+        sum += g.second;
+    for (auto &o : r1.options)
+        opts += o.second;
+    for (int i = 0; i < footprint::NCATEGORIES; i++) {
+        assert(sum.bytes[i] <= r1.total.bytes[i]);
+        assert(opts.bytes[i] <= sum.bytes[i]);
+    }
+    assert(r1.groups.size() == 3 && r1.groups.count("extra"));
+    assert(r1.options.size() == 3 && r1.options[0].first == "count");
+    assert(r1.options[0].second.bytes[footprint::TEXT] > 1000);
+    assert(r1.total.bytes[footprint::UNKNOWN_ARGS] > 0);
+    assert(r1.options[1].second.bytes[footprint::VALUES] >= 3 * sizeof(args_parser::value));
+    // the big map shows up in its option, group and category
+    size_t big = r2.options[2].second.bytes[footprint::KVMAPS] - r1.options[2].second.bytes[footprint::KVMAPS];
+    assert(big > 500 * 2 * sizeof(std::string));
+    assert(r2.groups["extra"].total() - r1.groups["extra"].total() >= big);
+    assert(r2.groups[""].total() == r1.groups[""].total());
+    assert(r2.total.total() > r1.total.total() + big);
+    std::stringstream out;
+    args_parser p3(3, argv1, "--", '=', out);
+    p3.add<int>("count", 1);
+    p3.set_flag(args_parser::SILENT);
+    p3.print_footprint();
+    assert(out.str().find("Memory footprint: ") == 0 && out.str().find("kvmaps: ") != std::string::npos);
+}
+
 void check_parser()
 {
     basic_scalar_check<int>(5);
@@ -549,6 +1164,10 @@ void check_parser()
     basic_scalar_check<bool>(true);
     basic_scalar_check<bool>(true);
     basic_scalar_check<std::string>("ccc");
+    basic_scalar_check<int64_t>(5000000000LL);
+    basic_scalar_check<int64_t>(-5);
+    basic_scalar_check<double>(5.5);
+    basic_scalar_check<double>(-1e-300);
     
     basic_vector_check<int>(5, 5);
     basic_vector_check<int>(5, -5);
@@ -558,11 +1177,15 @@ void check_parser()
     basic_vector_check<bool>(true, false);
     basic_vector_check<bool>(true, false);
     basic_vector_check<std::string>("ccc", "ddd");
+    basic_vector_check<int64_t>(-5000000000LL, 5);
+    basic_vector_check<double>(5.5, -1e300);
 
     default_scalar_check<int>(5);
     default_scalar_check<float>(5.5);
     default_scalar_check<bool>(true);
     default_scalar_check<std::string>("ccc");
+    default_scalar_check<int64_t>(1LL << 40);
+    default_scalar_check<double>(0.25);
 
     default_vector_check<int>("", 0);
     default_vector_check<int>("5", 1);
@@ -576,6 +1199,8 @@ void check_parser()
     default_vector_check<std::string>("", 0);
     default_vector_check<std::string>("ccc", 1);
     default_vector_check<std::string>("ccc,ddd", 2);
+    default_vector_check<int64_t>("5Gi,-5", 2);
+    default_vector_check<double>("5.5,1e-300", 2);
 
     default_vector_check_ext<int>("5,-5", "1", 2, 1, -5);
     default_vector_check_ext<int>("5,-5", "1,1", 2, 1, 1);
@@ -616,6 +1241,22 @@ void check_parser()
 
     check_extra_args();
 
+    check_batch();
+
+    check_hash();
+
+    check_diff();
+
+    check_int64_suffixes();
+
+    check_schema();
+
+    check_apply();
+    check_shared_schema();
+    check_parse_batch();
+    check_preparsed_defaults();
+    check_footprint();
+
 
 
 }
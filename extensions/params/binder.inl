@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2020-2024 Alexey V. Medvedev, Boris Krasnopolsky
+ * This code is licensed under 3-Clause BSD license.
+ * See license.txt file for details.
+ */
+
+#pragma once
+
+namespace params {
+
+template <class details, class S>
+template<typename T>
+binder<details, S> &binder<details, S>::bind(const std::string &key, T S::*member, bool required) {
+    const auto &expected_params = details::get_expected_params();
+    auto id = list<details>::get_id(key);
+    if (id == symbol_table<details>::npos) {
+        throw std::runtime_error(std::string("params: binder: unknown parameter: ") + key);
+    }
+    if (expected_params[id].second.type != value().get_type<T>()) {
+        throw std::runtime_error(std::string("params: binder: type mismatch on a parameter: ") + key);
+    }
+    get_bindings((T *)nullptr).push_back(binding<T> { id, member, required });
+    return *this;
+}
+
+template <class details, class S>
+template<typename K>
+binder<details, S> &binder<details, S>::bind(typename K::value_type S::*member, bool required) {
+    static_assert(std::is_same<typename K::schema, typename details::schema>::value, 
+                  "params: binder: the key doesn't belong to the schema");
+    get_bindings((typename K::value_type *)nullptr).push_back(binding<typename K::value_type> { K::id, member, required });
+    return *this;
+}
+
+template <class details, class S>
+template<typename T>
+void binder<details, S>::fill_in(const bindings_t<T> &bindings, const list<details> &l, S &target) {
+    for (const auto &b : bindings) {
+        if (!b.required && !l.is_value_set(b.id))
+            continue;
+        target.*(b.member) = l.template get_value_ref<T>(b.id);
+    }
+}
+
+template <class details, class S>
+void binder<details, S>::fill(const list<details> &l, S &target) const {
+    fill_in(ints, l, target);
+    fill_in(floats, l, target);
+    fill_in(strings, l, target);
+    fill_in(bools, l, target);
+    fill_in(ivecs, l, target);
+    fill_in(fvecs, l, target);
+    fill_in(svecs, l, target);
+    fill_in(bvecs, l, target);
+}
+
+template <class details, class S>
+void binder<details, S>::fill(const dictionary<details> &dict, const std::string &list_name, int layer, S &target) const {
+    fill(dict.get(list_name, layer), target);
+}
+
+template <class details, class S>
+size_t binder<details, S>::size() const {
+    return ints.size() + floats.size() + strings.size() + bools.size() + 
+           ivecs.size() + fvecs.size() + svecs.size() + bvecs.size();
+}
+
+}
@@ -12,6 +12,8 @@ template <class details>
 void dictionary<details>::add(const std::string &name, const list<details> &l) {
     typedef std::pair<std::string, list<details>> item;
     m.insert(item(name, l));
+    by_position.valid = false;
+    mark_dirty(name);
 }
 
 template <class details>
@@ -34,6 +36,8 @@ void dictionary<details>::add_map(const std::string &name, const std::map<std::s
     }
     typedef std::pair<std::string, list<details>> item;
     m.insert(item(name, l));
+    by_position.valid = false;
+    mark_dirty(name);
 }
 
 template <class details>
@@ -45,6 +49,8 @@ void dictionary<details>::add_override(const std::string &name, const std::map<s
     }
     typedef std::pair<std::string, list<details>> item;
     m.insert(item(name + "_override", l));
+    by_position.valid = false;
+    mark_dirty(name + "_override");
 }
 
 template <class details>
@@ -53,23 +59,151 @@ bool dictionary<details>::find(const std::string &name) const {
 }
 
 template <class details>
-template <typename T>
-bool dictionary<details>::find_if(const std::vector<std::pair<std::string, T>> &conditions, 
-                                  std::string &found_list_name) const {
-    for (auto &i : m) {
-        bool match = false;
-        for (auto &c : conditions) {
-            T val;
-            if (i.second.template get_value<T>(c.first, val))
-                if (val == c.second) {
-                    match = true;
-                    found_list_name = i.first;
-                }
+void dictionary<details>::mark_dirty(const std::string &name) const {
+    if (!indexes.empty())
+        dirty_lists.insert(name);
+}
+
+template <class details>
+void dictionary<details>::index_list(const std::string &name) const {
+    auto &values = indexed_values[name];
+    for (auto &v : values) {
+        auto &idx = indexes[v.first];
+        auto bucket = idx.find(v.second);
+        if (bucket != idx.end()) {
+            bucket->second.erase(name);
+            if (bucket->second.empty())
+                idx.erase(bucket);
         }
-        if (match)
+    }
+    values.clear();
+    auto it = m.find(name);
+    if (it == m.end()) {
+        indexed_values.erase(name);
+        return;
+    }
+    for (auto &idx : indexes) {
+        auto elem = it->second.find_value(list<details>::get_id(idx.first));
+        if (!elem)
+            continue;
+        auto s = elem->as_string();
+        idx.second[s].insert(name);
+        values[idx.first] = s;
+    }
+}
+
+template <class details>
+void dictionary<details>::refresh_indexes() const {
+    // const lookups may go concurrently: one of them reindexes, the rest wait for it
+    std::lock_guard<std::mutex> lock(caches_guard.mtx);
+    for (auto &name : dirty_lists) {
+        index_list(name);
+    }
+    dirty_lists.clear();
+}
+
+template <class details>
+void dictionary<details>::add_index(const std::string &key) {
+    const auto &expected_params = details::get_expected_params();
+    list<details> l;
+    if (l.is_in_expected_params(key) == expected_params.end()) {
+        throw std::runtime_error(std::string("params: add_index: unknown parameter: ") + key);
+    }
+    indexes[key];
+    reindex();
+}
+
+template <class details>
+void dictionary<details>::reindex() {
+    by_position.valid = false;
+    for (auto &idx : indexes) {
+        idx.second.clear();
+    }
+    indexed_values.clear();
+    dirty_lists.clear();
+    if (indexes.empty())
+        return;
+    for (auto &i : m) {
+        index_list(i.first);
+    }
+}
+
+template <class details>
+template <typename T>
+bool dictionary<details>::match_conditions(const list<details> &l, 
+                                           const std::vector<std::pair<std::string, T>> &conditions, 
+                                           bool match_all) const {
+    for (auto &c : conditions) {
+        T val;
+        bool match = l.template get_value<T>(c.first, val) && val == c.second;
+        if (match && !match_all)
             return true;
+        if (!match && match_all)
+            return false;
+    }
+    return match_all && conditions.size();
+}
+
+template <class details>
+template <typename T>
+const std::string *dictionary<details>::lookup(const std::vector<std::pair<std::string, T>> &conditions, 
+                                               bool match_all) const {
+    // Returns the name of the first list in map order which matches any (match_all=false) 
+    // or all (match_all=true) of conditions. Indexed keys narrow the set of candidate lists,
+    // the candidates are then checked by the typed comparison.
+    refresh_indexes();
+    static const std::set<std::string> empty;
+    std::vector<const std::set<std::string> *> buckets;
+    for (auto &c : conditions) {
+        auto idx = indexes.find(c.first);
+        if (idx == indexes.end()) {
+            if (!match_all)
+                break;
+            continue;
+        }
+        value p;
+        p.set<T>(c.second);
+        auto bucket = idx->second.find(p.as_string());
+        buckets.push_back(bucket == idx->second.end() ? &empty : &(bucket->second));
+    }
+    bool use_index = (match_all ? buckets.size() != 0 : buckets.size() == conditions.size() && conditions.size());
+    if (!use_index) {
+        for (auto &i : m) {
+            if (match_conditions(i.second, conditions, match_all))
+                return &(i.first);
+        }
+        return nullptr;
+    }
+    if (match_all) {
+        // all conditions must match: it is enough to check the smallest bucket
+        auto smallest = *std::min_element(buckets.begin(), buckets.end(), 
+                [](const std::set<std::string> *a, const std::set<std::string> *b) { return a->size() < b->size(); });
+        buckets.assign(1, smallest);
     }
-    return false;
+    const std::string *result = nullptr;
+    for (auto bucket : buckets) {
+        for (auto &name : *bucket) {
+            if (result && !(name < *result))
+                break;
+            auto it = m.find(name);
+            if (it != m.end() && match_conditions(it->second, conditions, match_all)) {
+                result = &(it->first);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+template <class details>
+template <typename T>
+bool dictionary<details>::find_if(const std::vector<std::pair<std::string, T>> &conditions, 
+                                  std::string &found_list_name) const {
+    auto name = lookup(conditions, false);
+    if (!name)
+        return false;
+    found_list_name = *name;
+    return true;
 }
 
 template <class details>
@@ -83,40 +217,24 @@ template <class details>
 template <typename T>
 const list<details> &dictionary<details>::get_if(const std::vector<std::pair<std::string, T>> &conditions, 
                                std::string &found_list_name) const {
-    for (auto &i : m) {
-        // In fact, we do logical OR for all conditions. For a more complex logic, 
-        // lambda arg can be implemented
-        for (auto &c : conditions) {
-            T val;
-            if (i.second.template get_value<T>(c.first, val))
-                if (val == c.second) { 
-                    found_list_name = i.first;
-                    return i.second;
-            }
-        }
-    }
-    throw std::runtime_error("params: get_if: list not found for given conditions");
-    return *(new list<details>); // never can be reached
+    // In fact, we do logical OR for all conditions. For logical AND, see get_if_all()
+    auto name = lookup(conditions, false);
+    if (!name)
+        throw std::runtime_error("params: get_if: list not found for given conditions");
+    found_list_name = *name;
+    return get(found_list_name);
 }
 
 template <class details>
 template <typename T>
 list<details> &dictionary<details>::get_if(const std::vector<std::pair<std::string, T>> &conditions, 
                          std::string &found_list_name) {
-    for (auto &i : m) {
-        // In fact, we do logical OR for all conditions. For a more complex logic, 
-        // lambda arg can be implemented
-        for (auto &c : conditions) {
-            T val;
-            if (i.second.template get_value<T>(c.first, val))
-                if (val == c.second) { 
-                    found_list_name = i.first;
-                    return i.second;
-            }
-        }
-    }
-    throw std::runtime_error("params: get_if: list not found for given conditions");
-    return *(new list<details>); // never can be reached
+    // In fact, we do logical OR for all conditions. For logical AND, see get_if_all()
+    auto name = lookup(conditions, false);
+    if (!name)
+        throw std::runtime_error("params: get_if: list not found for given conditions");
+    found_list_name = *name;
+    return get(found_list_name);
 }
 
 template <class details>
@@ -133,11 +251,67 @@ list<details> &dictionary<details>::get_if(const std::vector<std::pair<std::stri
     return get_if(conditions, ignored_value);
 }
 
+template <class details>
+template <typename T>
+bool dictionary<details>::find_if_all(const std::vector<std::pair<std::string, T>> &conditions, 
+                                      std::string &found_list_name) const {
+    auto name = lookup(conditions, true);
+    if (!name)
+        return false;
+    found_list_name = *name;
+    return true;
+}
+
+template <class details>
+template <typename T>
+bool dictionary<details>::find_if_all(const std::vector<std::pair<std::string, T>> &conditions) const {
+    std::string ignored_value;
+    return find_if_all(conditions, ignored_value);
+}
+
+template <class details>
+template <typename T>
+const list<details> &dictionary<details>::get_if_all(const std::vector<std::pair<std::string, T>> &conditions, 
+                                                     std::string &found_list_name) const {
+    auto name = lookup(conditions, true);
+    if (!name)
+        throw std::runtime_error("params: get_if_all: list not found for given conditions");
+    found_list_name = *name;
+    return get(found_list_name);
+}
+
+template <class details>
+template <typename T>
+list<details> &dictionary<details>::get_if_all(const std::vector<std::pair<std::string, T>> &conditions, 
+                                               std::string &found_list_name) {
+    auto name = lookup(conditions, true);
+    if (!name)
+        throw std::runtime_error("params: get_if_all: list not found for given conditions");
+    found_list_name = *name;
+    return get(found_list_name);
+}
+
+template <class details>
+template <typename T>
+const list<details> &dictionary<details>::get_if_all(const std::vector<std::pair<std::string, T>> &conditions) const {
+    std::string ignored_value;
+    return get_if_all(conditions, ignored_value);
+}
+
+template <class details>
+template <typename T>
+list<details> &dictionary<details>::get_if_all(const std::vector<std::pair<std::string, T>> &conditions) {
+    std::string ignored_value;
+    return get_if_all(conditions, ignored_value);
+}
+
 template <class details>
 list<details> &dictionary<details>::get(const std::string &name) {
     if (!find(name)) {
         throw std::runtime_error(std::string("params: get: list not found: ") + name);
     }
+    // NOTE: the list may be changed via the returned reference, so it is reindexed on the next query
+    mark_dirty(name);
     return m.find(name)->second;
 }
 
@@ -154,19 +328,42 @@ const std::string &dictionary<details>::get(size_t num) const {
     if (num >= size()) {
         throw std::runtime_error(std::string("params: get: index out of bounds: ") + std::to_string(num));
     }
-    auto it = m.begin();
-    std::advance(it, num);
-    return it->first;
+    std::lock_guard<std::mutex> lock(caches_guard.mtx);
+    auto &positions = by_position.positions;
+    if (!by_position.valid || positions.size() != m.size()) {
+        positions.clear();
+        positions.reserve(m.size());
+        for (auto it = m.cbegin(); it != m.cend(); ++it) {
+            positions.push_back(it);
+        }
+        by_position.valid = true;
+    }
+    return positions[num]->first;
+}
+
+template <class details>
+bool dictionary<details>::fill_in_overrides(const std::string &name, overrides_holder<details> &holder) const {
+    // NOTE: textual overrides go first, so that on-layer changes made later take precedence
+    bool found = false;
+    if (find(name + "_override")) {
+        holder.fill_in(get(name + "_override"));
+        found = true;
+    }
+    auto it = onlayer_overrides.find(name);
+    if (it != onlayer_overrides.end()) {
+        holder.fill_in(it->second);
+        found = true;
+    }
+    return found;
 }
 
 template <class details>
 list<details> dictionary<details>::get(const std::string &name, int layer) const {
     const auto &nlayers = details::get_nlayers();
-    if (!find(name + "_override")) {
+    overrides_holder<details> holder(nlayers);
+    if (!fill_in_overrides(name, holder)) {
         return get(name);
     }
-    overrides_holder<details> holder(nlayers);
-    holder.fill_in(get(name + "_override"));
     list<details> l = get(name);
     if (holder.find(layer)) {
         auto &overrides = holder.get(layer);
@@ -175,6 +372,94 @@ list<details> dictionary<details>::get(const std::string &name, int layer) const
     return l;
 }
 
+template <class details>
+list<details> dictionary<details>::get_overrides(const std::string &name) const {
+    // Textual form of all overrides of a list, as it would be given in "_override" list.
+    // On-layer changes are kept as typed records and turned into text only here.
+    const std::string &layer_prefix = details::get_layer_prefix();
+    list<details> result;
+    if (find(name + "_override")) {
+        result = get(name + "_override");
+    }
+    result.omit_value_coversions_and_checks = true;
+    auto it = onlayer_overrides.find(name);
+    if (it == onlayer_overrides.end()) {
+        return result;
+    }
+    for (auto &i : it->second) {
+        std::string s;
+        result.get_value(i.first, s);
+        for (auto &o : i.second) {
+            if (!s.empty())
+                s += ";";
+            s += o.v.as_string() + "@" + layer_prefix + std::to_string(o.start);
+            if (o.end != o.start)
+                s += "-" + std::to_string(o.end);
+        }
+        result.template set_value<std::string>(i.first, s);
+    }
+    return result;
+}
+
+template <class details>
+template<typename T>
+std::vector<typename layer_value<T>::type> dictionary<details>::get_all_layers(const std::string &list_name, 
+                                                                              const std::string &key) const {
+    // Resolved value of a parameter for each layer 0..nlayers-1 at once: base value
+    // overridden by textual and on-layer overrides in the same order as get(name, layer) does
+    const size_t nlayers = details::get_nlayers();
+    const auto &expected_params = details::get_expected_params();
+    const auto &l = get(list_name);
+    auto item_it = l.is_in_expected_params(key);
+    if (item_it == expected_params.end()) {
+        throw std::runtime_error(std::string("params: get_all_layers: unknown parameter: ") + key);
+    }
+    value probe;
+    if (probe.get_type<T>() != (item_it->second).type) {
+        throw std::runtime_error(std::string("params: get_all_layers: type mismatch on a parameter: ") + key);
+    }
+    // the base value may be missing if overrides give it on every layer
+    T base = T();
+    bool has_base = l.get_value(key, base);
+    std::vector<typename layer_value<T>::type> result(nlayers, base);
+    std::vector<bool> is_set(nlayers, has_base);
+    auto fill = [&](const T &v, size_t start, size_t end) {
+        end = std::min(end + 1, nlayers);
+        for (size_t layer = start; layer < end; layer++) {
+            result[layer] = v;
+            is_set[layer] = true;
+        }
+    };
+    std::string textual;
+    if (find(list_name + "_override") && get(list_name + "_override").get_value(key, textual)) {
+        overrides_holder<details> holder(nlayers);
+        for (const auto &part : helpers::str_split(textual, ';')) {
+            std::string v;
+            size_t start, end;
+            holder.get_part(part, v, start, end);
+            list<details> parsed;
+            parsed.parse_and_set_value(key, v);
+            fill(parsed.template get_value<T>(key), start, end);
+        }
+    }
+    auto it = onlayer_overrides.find(list_name);
+    if (it != onlayer_overrides.end()) {
+        auto records = it->second.find(key);
+        if (records != it->second.end()) {
+            for (auto &o : records->second) {
+                fill(o.v.template get<T>(), o.start, o.end);
+            }
+        }
+    }
+    for (size_t layer = 0; layer < nlayers; layer++) {
+        if (!is_set[layer]) {
+            throw std::runtime_error(std::string("params: get_all_layers: no value on layer ") + 
+                                     std::to_string(layer) + " for a parameter: " + key);
+        }
+    }
+    return result;
+}
+
 template <class details>
 template<typename T>
 void dictionary<details>::change_value(const std::string &list_name, const std::string &key, const T &value) {
@@ -194,23 +479,29 @@ template <class details>
 template<typename T>
 void dictionary<details>::internal_change_value_onlayer(const std::string &list_name, const std::string &key, 
                                            const T &v, uint16_t layer, bool forced) {
-    const std::string &layer_prefix = details::get_layer_prefix();
-    std::string ol = list_name + "_override";
-    if (!find(ol)) {
-        add(ol, list<details> {});
+    const auto &expected_params = details::get_expected_params();
+    list<details> checked;
+    auto item_it = checked.is_in_expected_params(key);
+    if (item_it == expected_params.end()) {
+        throw std::runtime_error(std::string("params: change_value_onlayer: unknown parameter: ") + key);
     }
-    auto &target = get(ol);
-    std::string oldv;
-    if (target.get_value(key, oldv)) {
-        value p;
-        p.set<T>(v);
-        auto newv = oldv + ";" + p.as_string() + "@" + layer_prefix + std::to_string(layer);
-        target.template change_value<std::string>(key, newv, forced);
+    if (!(item_it->second).changeable && !forced) {
+        throw std::runtime_error(std::string("params: change_value_onlayer: parameter cannot be changed: ") + key);
+    }
+    value p;
+    p.set<T>(v);
+    if (p.type == (item_it->second).type) {
+        checked.set(key, p);
     } else {
-        value p;
-        p.set<T>(v);
-        target.template add_value<std::string>(key, p.as_string() + "@" + layer_prefix + std::to_string(layer));
+        // NOTE: type mismatch is resolved the same way as for textual overrides
+        checked.parse_and_set_value(key, p.as_string());
     }
+    // an empty "_override" list stands for the on-layer changes in the dictionary,
+    // their textual form is rendered by get_overrides()
+    if (!find(list_name + "_override")) {
+        add_override(list_name, {});
+    }
+    onlayer_overrides[list_name][key].push_back(layer_override { *checked.find_value(list<details>::get_id(key)), layer, layer });
 } 
 
 template <class details>
@@ -233,6 +524,64 @@ void dictionary<details>::set_defaults() {
     for (auto &i : m) {
         i.second.set_default(i.first);
     }
+    reindex();
+}
+
+// Parallel version: lists are handed out to nthreads workers in small chunks.
+// details::set_family_defaults() must be safe to call for different lists concurrently.
+// In case of errors, the exception of the first failing list in map order is rethrown;
+// unlike the sequential version, lists after the failing one may already have their
+// defaults set.
+template <class details>
+void dictionary<details>::set_defaults(size_t nthreads) {
+    if (nthreads < 2 || m.size() < 2) {
+        set_defaults();
+        return;
+    }
+    details::set_dictionary_defaults(*this);
+    std::vector<typename std::map<std::string, list<details>>::iterator> lists;
+    lists.reserve(m.size());
+    for (auto it = m.begin(); it != m.end(); ++it) {
+        lists.push_back(it);
+    }
+    std::vector<std::exception_ptr> errors(lists.size());
+    constexpr size_t chunk = 16;
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> first_failed(lists.size());
+    auto worker = [&]() {
+        for (;;) {
+            size_t start = next.fetch_add(chunk);
+            if (start >= lists.size())
+                return;
+            size_t end = std::min(start + chunk, lists.size());
+            for (size_t n = start; n < end; n++) {
+                // nothing after the already known first failure may change the result
+                if (n > first_failed.load())
+                    return;
+                try {
+                    lists[n]->second.set_default(lists[n]->first);
+                }
+                catch (...) {
+                    errors[n] = std::current_exception();
+                    size_t f = first_failed.load();
+                    while (n < f && !first_failed.compare_exchange_weak(f, n)) {}
+                }
+            }
+        }
+    };
+    nthreads = std::min(nthreads, (lists.size() + chunk - 1) / chunk);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nthreads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : threads) {
+        t.join();
+    }
+    if (first_failed.load() < lists.size()) {
+        std::rethrow_exception(errors[first_failed.load()]);
+    }
+    reindex();
 }
 
 template <class details>
@@ -242,6 +591,14 @@ void dictionary<details>::print() const {
 
 template <class details>
 void dictionary<details>::print_list(const std::string &list_name, const std::string &header_name, bool omit_undefined) const {
+    std::stringstream ss;
+    render_list(ss, list_name, header_name, omit_undefined);
+    details::print_stream(ss);
+}
+
+template <class details>
+void dictionary<details>::render_list(std::ostream &out, const std::string &list_name, const std::string &header_name, 
+                                      bool omit_undefined) const {
     const auto &family_key = details::get_family_key();
     const auto &nlayers = details::get_nlayers();
     const auto &expected_params = details::get_expected_params();
@@ -250,48 +607,42 @@ void dictionary<details>::print_list(const std::string &list_name, const std::st
     }
     auto &l = get(list_name);
     if (header_name.size()) {
-        list<details>::print_line_delimiter();
-        list<details>::print_header(header_name);
+        list<details>::render_line_delimiter(out);
+        list<details>::render_header(out, header_name);
     }
-    list<details>::print_line_delimiter();
-    overrides_holder<details> holder(nlayers);
-    if (find(list_name + "_override")) {
-        holder.fill_in(get(list_name + "_override"));
+    list<details>::render_line_delimiter(out);
+    const std::string suffix = "_override";
+    if (list_name.size() > suffix.size() && 
+        list_name.compare(list_name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        // the text of an "_override" list is built here, with on-layer changes in it
+        auto text = get_overrides(list_name.substr(0, list_name.size() - suffix.size()));
+        text.for_each_value([&](param_id_t id, const value &) {
+            text.render_line(out, symbol_table<details>::get().name(id), "", omit_undefined);
+        });
+        list<details>::render_line_delimiter(out);
+        return;
     }
+    overrides_holder<details> holder(nlayers);
+    fill_in_overrides(list_name, holder);
     const std::string &layer_prefix = details::get_layer_prefix();    
-    auto this_family = l.template get_value<std::string>(family_key);
-    for (auto &e : expected_params) {
-        auto &m = e.second.matching_families;
-        bool match = true;
-        if (m.size()) {
-            for (auto &family : m) {
-                if (std::regex_match(family, std::regex("^!.*"))) {
-                    if (family == "!" + this_family) {
-                        match = false;
-                        break;
-                    }
-                } else if (family == this_family) {
-                    match = true;
+    const auto &applicable = symbol_table<details>::get().applicable(l.template get_value<std::string>(family_key));
+    for (size_t id = 0; id < expected_params.size(); id++) {
+        auto &e = expected_params[id];
+        if (applicable.test((param_id_t)id)) {
+            l.render_line(out, e.first, "", omit_undefined);
+            // NOTE: per_layer_lists is ordered by layer number
+            for (auto &per_layer : holder.per_layer_lists) {
+                if (per_layer.first >= nlayers)
                     break;
-                } else {
-                    match = false;
-                }
-            }
-        }
-        if (match) {
-            l.print_line(e.first, "", omit_undefined);
-            for (int layer = 0; layer < nlayers; layer++) {
-                if (holder.find(layer)) {
-                    auto &per_layer_list = holder.get(layer);
-                    std::string ignored;
-                    if (per_layer_list.get_value_as_string(e.first, ignored)) {
-                        per_layer_list.print_line(e.first, e.first + " (" + layer_prefix + "." + std::to_string(layer) + ")");
-                    }
+                auto &per_layer_list = per_layer.second;
+                if (per_layer_list.is_value_set(e.first)) {
+                    per_layer_list.render_line(out, e.first, e.first + " (" + layer_prefix + "." + 
+                                               std::to_string(per_layer.first) + ")");
                 }
             }
         }
     }
-    list<details>::print_line_delimiter();
+    list<details>::render_line_delimiter(out);
 }
 
 template <typename details>
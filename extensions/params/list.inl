@@ -36,6 +36,139 @@ static inline std::vector<std::string> str_split(const std::string &s, char deli
 
 namespace params {
 
+template <class details>
+constexpr param_id_t symbol_table<details>::npos;
+
+template <class details>
+symbol_table<details>::symbol_table() {
+    const auto &expected_params = details::get_expected_params();
+    nparams = expected_params.size();
+    if (nparams >= npos) {
+        throw std::runtime_error("params: symbol_table: too many expected parameters");
+    }
+    for (size_t id = 0; id < nparams; id++) {
+        by_name.push_back((param_id_t)id);
+    }
+    // NOTE: the first entry wins for a duplicate key, same as for a linear search
+    std::stable_sort(by_name.begin(), by_name.end(), 
+              [&expected_params](param_id_t a, param_id_t b) { return expected_params[a].first < expected_params[b].first; });
+    by_name.erase(std::unique(by_name.begin(), by_name.end(), 
+              [&expected_params](param_id_t a, param_id_t b) { return expected_params[a].first == expected_params[b].first; }), 
+              by_name.end());
+    // Applicability depends only on whether the family equals any of the names in
+    // matching_families, so any family which is not mentioned there shares one mask
+    for (const auto &e : expected_params) {
+        for (const auto &family : e.second.matching_families) {
+            auto name = (family.size() && family[0] == '!' ? family.substr(1) : family);
+            family_masks.emplace(name, param_mask(nparams));
+        }
+    }
+    other_families_mask = param_mask(nparams);
+    for (size_t id = 0; id < nparams; id++) {
+        const auto &m = expected_params[id].second.matching_families;
+        for (auto &fm : family_masks) {
+            if (is_applicable(m, &fm.first))
+                fm.second.set((param_id_t)id);
+        }
+        if (is_applicable(m, nullptr))
+            other_families_mask.set((param_id_t)id);
+    }
+}
+
+template <class details>
+bool symbol_table<details>::is_applicable(const std::vector<std::string> &matching_families, 
+                                          const std::string *family) {
+    // NOTE: family == nullptr stands for a family which is not equal to any of matching_families;
+    // the order of checks is essential: the last non-matching positive entry makes it false,
+    // the first matching entry decides
+    bool match = true;
+    for (auto &f : matching_families) {
+        if (f.size() && f[0] == '!') {
+            if (family && f.compare(1, std::string::npos, *family) == 0) {
+                match = false;
+                break;
+            }
+        } else if (family && f == *family) {
+            match = true;
+            break;
+        } else {
+            match = false;
+        }
+    }
+    return match;
+}
+
+template <class details>
+const param_mask &symbol_table<details>::applicable(const std::string &family) const {
+    auto it = family_masks.find(family);
+    return (it == family_masks.end() ? other_families_mask : it->second);
+}
+
+template <class details>
+param_id_t symbol_table<details>::find(const std::string &key) const {
+    // the table is small, so a binary search over sorted names beats hashing
+    const auto &expected_params = details::get_expected_params();
+    size_t lo = 0, hi = by_name.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = expected_params[by_name[mid]].first.compare(key);
+        if (cmp == 0)
+            return by_name[mid];
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return npos;
+}
+
+template <class details>
+const value *list<details>::find_value(param_id_t id) const {
+    if (!l || id >= l->size())
+        return nullptr;
+    return (*l)[id].get();
+}
+
+template <class details>
+typename list<details>::entries_t &list<details>::writable_entries() {
+    if (!l) {
+        l = std::make_shared<entries_t>(symbols::get().size());
+    } else if (l.use_count() > 1) {
+        l = std::make_shared<entries_t>(*l);
+    } else {
+        // pairs with the release of the last other owner, which may be in another thread
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *l;
+}
+
+template <class details>
+void list<details>::store(param_id_t id, value &&v) {
+    if (v.type == value::NUL) {
+        store(id, nullptr);
+        return;
+    }
+    writable_entries()[id] = std::make_shared<const value>(std::move(v));
+}
+
+template <class details>
+void list<details>::store(param_id_t id, const std::shared_ptr<const value> &v) {
+    if (!v && !find_value(id))
+        return;
+    writable_entries()[id] = v;
+}
+
+template <class details>
+template <typename F>
+void list<details>::for_each_value(F func) const {
+    if (!l)
+        return;
+    for (auto id : symbols::get().sorted()) {
+        if ((*l)[id])
+            func(id, *(*l)[id]);
+    }
+}
+
 template <class details>
 void list<details>::init(const std::string &key, const std::string &value) {
     const auto &expected_params = details::get_expected_params();
@@ -55,9 +188,8 @@ template <class details>
 typename expected_params_t::const_iterator 
 list<details>::is_in_expected_params(const std::string &key) const {
     const auto &expected_params = details::get_expected_params();
-    return std::find_if(expected_params.cbegin(), 
-                        expected_params.cend(), 
-                        [key](const expected_params_t::value_type &i) { return i.first == key; } );
+    auto id = get_id(key);
+    return (id == symbols::npos ? expected_params.cend() : expected_params.cbegin() + id);
 }
 
 template <class details>
@@ -96,20 +228,20 @@ void list<details>::parse_and_set_value(const std::string &key, const std::vecto
 
 template <class details>
 value::type_t list<details>::get_type(const std::string &key) const {
-    auto elem = l.find(key);
-    if (elem == l.end())
+    auto elem = find_value(get_id(key));
+    if (!elem)
         return value::type_t::NUL;
     else
-        return elem->second.type;
+        return elem->type;
 }
 
 template <class details>
 void list<details>::set_unsafe(const std::string &key, const value &p) {
-    auto elem = l.find(key);
-    if (elem != l.end())
-        elem->second = p;
-    else
-        l.insert(std::pair<std::string, value>(key, p));
+    auto id = get_id(key);
+    if (id == symbols::npos) {
+        throw std::runtime_error(std::string("params: set: unknown parameter: ") + key);
+    }
+    store(id, value(p));
 }
 
 template <class details>
@@ -153,8 +285,7 @@ void list<details>::set_value_if_missing(const std::string &key, const T &v) {
     if (is_in_expected_params(key) == expected_params.end()) {
         throw std::runtime_error(std::string("params: set_value_if_missing: unknown parameter: ") + key);
     }
-    auto elem = l.find(key);
-    if (elem == l.end()) {
+    if (!find_value(get_id(key))) {
         value obj;
         if (!omit_value_coversions_and_checks) {
             if ((is_in_expected_params(key)->second).type != obj.get_type<T>()) {
@@ -165,7 +296,7 @@ void list<details>::set_value_if_missing(const std::string &key, const T &v) {
             }
         }
         obj.set<T>(v);
-        l.insert(std::pair<std::string, value>(key, obj));
+        store(get_id(key), std::move(obj));
     }
 }
 
@@ -191,8 +322,12 @@ void list<details>::change_value(const std::string &key, const T &v, bool forced
 
 template <class details>
 void list<details>::override_params(const list &other) {
-    for (auto &i : other.l) {
-        override_param(i.first, i.second);
+    // NOTE: we assume that all value checks are done before
+    if (!other.l)
+        return;
+    for (param_id_t id = 0; id < other.l->size(); id++) {
+        if ((*other.l)[id])
+            store(id, (*other.l)[id]);
     }
 }
 
@@ -203,7 +338,7 @@ void list<details>::add_value(const std::string &key, const T &v) {
     if (is_in_expected_params(key) == expected_params.end()) {
         throw std::runtime_error(std::string("params: add_value: unknown parameter: ") + key);
     }
-    if (l.find(key) != l.end()) {
+    if (find_value(get_id(key))) {
         throw std::runtime_error(std::string("params: add_value: parameter is already set: ") + key);
     }
     set_value(key, v);
@@ -212,59 +347,128 @@ void list<details>::add_value(const std::string &key, const T &v) {
 template <class details>
 template<typename T>
 bool list<details>::get_value(const std::string &key, T &v) const {
-    auto elem = l.find(key);
-    if (elem == l.end())
+    auto elem = find_value(get_id(key));
+    if (!elem || elem->type != value().get_type<T>())
         return false;
-    else
-        v = elem->second.template get<T>();
+    v = elem->template get<T>();
     return true;
 }
 
 template <class details>
 template<typename T>
 T list<details>::get_value(const std::string &key) const {
-    T val;
-    bool r = get_value<T>(key, val);
-    if (!r)
+    return get_value_ref<T>(key);
+}
+
+template <class details>
+template<typename T>
+const T &list<details>::get_value_ref(const std::string &key) const {
+    auto id = get_id(key);
+    if (!find_value(id))
         throw std::runtime_error(std::string("params: get_value: unknown parameter or parameter is not set: ") + key);
-    return val;
+    return get_value_ref<T>(id);
+}
+
+template <class details>
+template<typename T>
+const T &list<details>::get_value_ref(param_id_t id) const {
+    auto elem = find_value(id);
+    if (!elem)
+        throw std::runtime_error(std::string("params: get_value: unknown parameter or parameter is not set: ") + 
+                                 (id < symbols::get().size() ? symbols::get().name(id) : std::to_string(id)));
+    if (elem->type != elem->template get_type<T>())
+        throw std::runtime_error(std::string("params: get_value: type mismatch on a parameter: ") + symbols::get().name(id));
+    return elem->template get<T>();
+}
+
+template <class details>
+template<typename K>
+const typename K::value_type &list<details>::get() const {
+    static_assert(std::is_same<typename K::schema, typename details::schema>::value, 
+                  "params: get: the key doesn't belong to the schema of the list");
+    auto v = find_value(K::id);
+    if (v && v->type == K::type)
+        return v->template get<typename K::value_type>();
+    // not set or stored unconverted: get_value_ref() throws the proper exception
+    return get_value_ref<typename K::value_type>(K::id);
+}
+
+template <class details>
+template<typename K>
+void list<details>::set(const typename K::value_type &v) {
+    static_assert(std::is_same<typename K::schema, typename details::schema>::value, 
+                  "params: set: the key doesn't belong to the schema of the list");
+    if (K::constrained && !omit_value_coversions_and_checks) {
+        value obj;
+        obj.set<typename K::value_type>(v);
+        if (!is_value_allowed(K::name_str(), obj)) {
+            throw std::runtime_error(std::string("params: set_value: not allowed parameter value for key: ") + K::name_str());
+        }
+        store(K::id, std::move(obj));
+        return;
+    }
+    value obj;
+    obj.set<typename K::value_type>(v);
+    store(K::id, std::move(obj));
+}
+
+template <class details>
+template<typename K>
+void list<details>::change(const typename K::value_type &v) {
+    static_assert(K::changeable, "params: change: parameter cannot be changed");
+    set<K>(v);
+}
+
+template <class details>
+const param_mask &list<details>::get_applicable_params() const {
+    return symbols::get().applicable(get_value_ref<std::string>(details::get_family_key()));
+}
+
+template <class details>
+bool list<details>::is_param_applicable(const std::string &key) const {
+    return get_applicable_params().test(get_id(key));
 }
 
 template <class details>
 bool list<details>::is_value_set(const std::string &key) const {
-    return l.find(key) != l.end();
+    return find_value(get_id(key)) != nullptr;
 }
 
 template <class details>
 std::string list<details>::get_value_as_string(const std::string &key) const {
-    auto elem = l.find(key);
-    if (elem == l.end()) {
+    std::string result;
+    if (!get_value_as_string(key, result)) {
         throw std::runtime_error(std::string("params: get_value_as_string: unknown parameter or parameter is not set: ") + key);
     }
-	auto it = print_converters.find(key);
-	if (it != print_converters.end()) {
-		if (print_converters.at(key)) {
-			return print_converters.at(key)(elem->second);
-		}
-	}
-    return elem->second.as_string();
+    return result;
 }
 
 template <class details>
 bool list<details>::get_value_as_string(const std::string &key, std::string &result) const {
-    auto elem = l.find(key);
-    if (elem != l.end()) {
-        auto it = print_converters.find(key);
-        if (it != print_converters.end()) {
-            if (print_converters.at(key)) {
-                result = print_converters.at(key)(elem->second);
-                return true;
-            }
-        }
-        result = elem->second.as_string();
-        return true;
+    auto id = get_id(key);
+    auto elem = find_value(id);
+    if (!elem)
+        return false;
+    if (print_converters && id < print_converters->size() && (*print_converters)[id]) {
+        result = (*print_converters)[id](*elem);
+    } else {
+        result = elem->as_string();
     }
-    return false;
+    return true;
+}
+
+template <class details>
+size_t list<details>::raw_list_view::size() const {
+    if (!l)
+        return 0;
+    return (size_t)std::count_if(l->begin(), l->end(), [](const std::shared_ptr<const value> &v) { return (bool)v; });
+}
+
+template <class details>
+std::map<std::string, value> list<details>::copy_raw_list() const {
+    std::map<std::string, value> result;
+    for_each_value([&result](param_id_t id, const value &v) { result.emplace(symbols::get().name(id), v); });
+    return result;
 }
 
 template <class details>
@@ -354,68 +558,111 @@ bool list<details>::is_value_allowed(const std::string &key, const value &p) {
 
 template <class details>
 bool list<details>::erase() {
-    l.erase(l.begin(), l.end());
+    l.reset();
     return true;
 }
 
 template <class details>
 void list<details>::print(const std::string &header) {
+    std::stringstream ss;
+    render(ss, header);
+    details::print_stream(ss);
+}
+
+template <class details>
+void list<details>::render(std::ostream &out, const std::string &header) const {
     if (header != "") {
-        print_line_delimiter();
-        print_header(header);
-        print_line_delimiter();
-    }
-    for (auto &i : l) {
-        print_line(i.first);
+        render_line_delimiter(out);
+        render_header(out, header);
+        render_line_delimiter(out);
     }
+    for_each_value([this, &out](param_id_t id, const value &) { render_line(out, symbols::get().name(id)); });
 }
 
 template <class details>
 void list<details>::add_print_converter(const std::string &key, std::function<std::string(const value &)> func) {
-    print_converters[key] = func;
+    auto id = get_id(key);
+    if (id == symbols::npos) {
+        throw std::runtime_error(std::string("params: add_print_converter: unknown parameter: ") + key);
+    }
+    if (!print_converters) {
+        print_converters = std::make_shared<print_converters_t>();
+    } else if (print_converters.use_count() > 1) {
+        print_converters = std::make_shared<print_converters_t>(*print_converters);
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    if (id >= print_converters->size())
+        print_converters->resize(id + 1);
+    (*print_converters)[id] = func;
 }
 
 template <class details>
 void list<details>::remove_print_converter(const std::string &key) {
-    print_converters[key] = nullptr;
+    auto id = get_id(key);
+    if (!print_converters || id >= print_converters->size())
+        return;
+    if (print_converters.use_count() > 1) {
+        print_converters = std::make_shared<print_converters_t>(*print_converters);
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    (*print_converters)[id] = nullptr;
 }
 
 template <class details>
 void list<details>::print_line(const std::string &key, const std::string &out, bool omit_undefined) const {
-    const auto &family_key = details::get_family_key();
-    if (key == family_key && key == "-")
-        return;
-    std::string str_key = (out == "" ? key : out);
-    std::string str_value = "[UNDEFINED]";
-    get_value_as_string(key, str_value);
-    if (omit_undefined && str_value == "[UNDEFINED]")
-        return;
     std::stringstream ss;
-    ss << std::setfill(' ') << "| " << std::left
-       << std::setw(ARGPARSER_PARAMS_TABLEWIDTH_1STCOLUMN) 
-       << str_key << " | " 
-       << std::right << std::setw(ARGPARSER_PARAMS_TABLEWIDTH - ARGPARSER_PARAMS_TABLEWIDTH_1STCOLUMN - 8)
-       << str_value << " |" << std::endl;
-    details::print_stream(ss);
+    render_line(ss, key, out, omit_undefined);
+    if (ss.tellp() > 0)
+        details::print_stream(ss);
 }
 
 template <class details>
 void list<details>::print_header(const std::string str, uint16_t offset) {
     std::stringstream ss;
-    ss << std::setfill(' ') << std::left << "| "
-       << std::setw(offset) << "" << std::setw(ARGPARSER_PARAMS_TABLEWIDTH - 5 - offset) << str << " |"
-       << std::endl;
+    render_header(ss, str, offset);
     details::print_stream(ss);
 }
 
 template <class details>
 void list<details>::print_line_delimiter() {
     std::stringstream ss;
-    ss << std::right << std::setfill('-') << "|" 
-       << std::setw(ARGPARSER_PARAMS_TABLEWIDTH - 2) << "|" << std::endl;
+    render_line_delimiter(ss);
     details::print_stream(ss);
 }
 
+template <class details>
+void list<details>::render_line(std::ostream &out, const std::string &key, const std::string &out_key, 
+                                bool omit_undefined) const {
+    const auto &family_key = details::get_family_key();
+    if (key == family_key && key == "-")
+        return;
+    const std::string &str_key = (out_key == "" ? key : out_key);
+    std::string str_value = "[UNDEFINED]";
+    get_value_as_string(key, str_value);
+    if (omit_undefined && str_value == "[UNDEFINED]")
+        return;
+    out << std::setfill(' ') << "| " << std::left
+        << std::setw(ARGPARSER_PARAMS_TABLEWIDTH_1STCOLUMN) 
+        << str_key << " | " 
+        << std::right << std::setw(ARGPARSER_PARAMS_TABLEWIDTH - ARGPARSER_PARAMS_TABLEWIDTH_1STCOLUMN - 8)
+        << str_value << " |" << '\n';
+}
+
+template <class details>
+void list<details>::render_header(std::ostream &out, const std::string &str, uint16_t offset) {
+    out << std::setfill(' ') << std::left << "| "
+        << std::setw(offset) << "" << std::setw(ARGPARSER_PARAMS_TABLEWIDTH - 5 - offset) << str << " |"
+        << '\n';
+}
+
+template <class details>
+void list<details>::render_line_delimiter(std::ostream &out) {
+    out << std::right << std::setfill('-') << "|" 
+        << std::setw(ARGPARSER_PARAMS_TABLEWIDTH - 2) << "|" << '\n';
+}
+
 template <class details>
 void list<details>::set_default(const std::string &list_name) {
     const auto &family_key = details::get_family_key();
@@ -43,31 +43,61 @@ void overrides_holder<details>::get_start_end_layer(const std::string &s, size_t
     }
 }
 
+template <class details>
+void overrides_holder<details>::get_part(const std::string &part, std::string &v, size_t &start, size_t &end) {
+    // split part by @ -> { v0, v1 }
+    // extract start and end layer from v1, check maxlayer value for end
+    auto parts = helpers::str_split(part, '@');
+    if (parts.size() != 2) {
+        throw std::runtime_error(std::string("params: overrides_holder: fill_in: syntax error in part: ") + part);
+    }
+    get_start_end_layer(parts[1], start, end);
+    end = std::min(end, nlayers);
+    start = std::min(start, nlayers);
+    if (start > end) {
+        throw std::runtime_error(std::string("params: overrides_holder: fill_in: syntax error in part: ") + part);
+    }
+    v = parts[0];
+}
+
 template <class details>
 void overrides_holder<details>::fill_in(const list<details> &in) {
     // for each in "in" ->  { key, val }
-    //     split val by @ -> { v0, v1 }
-    //     extract start and end layer from v1, check maxlayer value for end
+    //     for each part of val: get_part() -> { v0, start, end }
     //     for (layer=start..end)
     //         lists[layer].add(key, v0)
-    for (auto &i : in.get_raw_list()) {
-        auto &key = i.first;
-        auto &value = i.second.template get<std::string>();
+    in.for_each_value([this](param_id_t id, const value &val) {
+        const auto &key = list<details>::symbols::get().name(id);
+        auto &value = val.template get<std::string>();
         auto parts = helpers::str_split(value, ';');
         for (const auto &part : parts) {
-            auto v = helpers::str_split(part, '@');
-            if (v.size() != 2) {
-                throw std::runtime_error(std::string("params: overrides_holder: fill_in: syntax error in part: ") + part);
-            }
+            std::string v;
             size_t start, end;
-            get_start_end_layer(v[1], start, end);
-            end = std::min(end, nlayers);
-            start = std::min(start, nlayers);
-            if (start > end) {
-                throw std::runtime_error(std::string("params: overrides_holder: fill_in: syntax error in part: ") + part);
+            get_part(part, v, start, end);
+            // parsed once, the value is shared by all the layers of the range
+            list<details> parsed;
+            parsed.parse_and_set_value(key, v);
+            auto shared = (parsed.l ? (*parsed.l)[id] : nullptr);
+            for (size_t layer = start; layer <= end; layer++) {
+                per_layer_lists[layer].store(id, shared);
             }
+        }
+    });
+}
+
+template <class details>
+void overrides_holder<details>::fill_in(const layer_overrides_t &in) {
+    for (auto &i : in) {
+        auto id = list<details>::get_id(i.first);
+        if (id == symbol_table<details>::npos) {
+            throw std::runtime_error(std::string("params: overrides_holder: fill_in: unknown parameter: ") + i.first);
+        }
+        for (auto &o : i.second) {
+            size_t end = std::min(o.end, nlayers);
+            size_t start = std::min(o.start, nlayers);
+            auto shared = std::make_shared<const value>(o.v);
             for (size_t layer = start; layer <= end; layer++) {
-                per_layer_lists[layer].parse_and_set_value(key, v[0]);
+                per_layer_lists[layer].store(id, shared);
             }
         }
     }
@@ -76,9 +106,9 @@ void overrides_holder<details>::fill_in(const list<details> &in) {
 template <class details>
 template <typename T>
 void overrides_holder<details>::apply_for_each_layer(const std::string &param_name, 
-                                            std::function<void (T, uint8_t)> f) 
+                                            std::function<void (T, size_t)> f) 
 {
-    for (uint8_t nl = 0; nl < nlayers; nl++) {
+    for (size_t nl = 0; nl < nlayers; nl++) {
         if (find(nl)) {
             auto &over_list = get(nl);
             T value;
@@ -10,9 +10,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <new>
+#include <set>
+#include <algorithm>
 #include <assert.h>
 #include <functional>
 #include <regex>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 typedef double float64_t; // FIXME this is actually system-dependent 
 
@@ -29,14 +37,24 @@ struct value {
     template <typename T> type_t get_type() const;
     static std::string get_max_possible_value(type_t);
     template <typename T> T get_max_possible_value();
-    uint32_t i;
-    float64_t f;
-    bool b;
-    std::string s;
-    std::vector<uint32_t> iv;
-    std::vector<float64_t> fv;
-    std::vector<bool> bv;
-    std::vector<std::string> sv;
+    // NOTE: only the member which corresponds to the type is alive
+    union {
+        uint32_t i;
+        float64_t f;
+        bool b;
+        std::string s;
+        std::vector<uint32_t> iv;
+        std::vector<float64_t> fv;
+        std::vector<bool> bv;
+        std::vector<std::string> sv;
+    };
+    value() {}
+    value(const value &other);
+    value(value &&other);
+    value &operator=(const value &other);
+    value &operator=(value &&other);
+    ~value() { reset(); }
+    void reset();
     template<typename T> void set(T val);
     
     template<type_t to> void autoconv();
@@ -48,6 +66,15 @@ protected:
     template<typename T> const T &get() const;
     template<typename U> friend class list;
     template<typename U> friend struct overrides_holder;
+    template<typename U> friend struct dictionary;
+    // reading a member other than the alive one is undefined, so get<T>() checks it
+    void check_type(type_t t) const {
+        if (type != t)
+            throw std::runtime_error("params: value: type mismatch while accessing a value");
+    }
+    void copy_from(const value &other);
+    void move_from(value &other);
+    template <typename T> static void destroy(T &member) { member.~T(); }
 };
 
 struct param_traits {
@@ -61,6 +88,44 @@ struct param_traits {
 
 using expected_params_t = std::vector<std::pair<std::string, param_traits>>;
 
+using param_id_t = uint16_t;
+
+// Element type of per-layer value arrays: bool values go as uint8_t, so that
+// the array is contiguous like for the other types (std::vector<bool> is not)
+template <typename T> struct layer_value { using type = T; };
+template <> struct layer_value<bool> { using type = uint8_t; };
+
+// Set of parameter IDs
+struct param_mask {
+    std::vector<uint64_t> bits;
+    param_mask(size_t n = 0) : bits((n + 63) / 64, 0) {}
+    void set(param_id_t id) { bits[id / 64] |= (uint64_t(1) << (id % 64)); }
+    bool test(param_id_t id) const { return id / 64 < bits.size() && (bits[id / 64] & (uint64_t(1) << (id % 64))); }
+};
+
+// Interned parameter names: each key of details::get_expected_params() is given
+// a small integer ID, which is its position in the table. Built once per details type.
+template <class details>
+struct symbol_table {
+    static constexpr param_id_t npos = std::numeric_limits<param_id_t>::max();
+    static const symbol_table &get() { static const symbol_table table; return table; }
+    param_id_t find(const std::string &key) const;
+    const std::string &name(param_id_t id) const { return details::get_expected_params()[id].first; }
+    size_t size() const { return nparams; }
+    // IDs in the lexicographical order of names
+    const std::vector<param_id_t> &sorted() const { return by_name; }
+    // Parameters applicable to a family, as given by param_traits::matching_families
+    const param_mask &applicable(const std::string &family) const;
+protected:
+    symbol_table();
+    static bool is_applicable(const std::vector<std::string> &matching_families, const std::string *family);
+    std::vector<param_id_t> by_name;
+    size_t nparams = 0;
+    // masks for each family which is mentioned in matching_families, and for any other family
+    std::map<std::string, param_mask> family_masks;
+    param_mask other_families_mask;
+};
+
 template <class details> struct dictionary;
                                        
 template <class details>
@@ -76,10 +141,23 @@ public:
         init(key, value);
     }
 protected:
+    using symbols = symbol_table<details>;
     void init(const std::string &key, const std::string &value);
     expected_params_t::const_iterator is_in_expected_params(const std::string &key) const;
-    std::map<std::string, value> l;
-    std::map<std::string, std::function<std::string(value)>> print_converters;
+    // Values are kept in a dense array indexed by parameter ID, an unset parameter
+    // is a null pointer. Both arrays are allocated on the first write and are shared 
+    // copy-on-write between list copies; values are immutable and shared as well, so
+    // copying a list is O(1) and applying overrides costs O(number of overridden keys).
+    using entries_t = std::vector<std::shared_ptr<const value>>;
+    using print_converters_t = std::vector<std::function<std::string(const value &)>>;
+    std::shared_ptr<entries_t> l;
+    std::shared_ptr<print_converters_t> print_converters;
+    const value *find_value(param_id_t id) const;
+    entries_t &writable_entries();
+    void store(param_id_t id, value &&v);
+    void store(param_id_t id, const std::shared_ptr<const value> &v);
+    template <typename F>
+    void for_each_value(F func) const;
 public:
     void parse_and_set_value(const std::string &key, const std::string &value);
     void parse_and_set_value(const std::string &key, const std::vector<std::string> &vec);
@@ -110,8 +188,36 @@ public:
     std::vector<float64_t> get_vfloat(const std::string &key) const { return get_value<std::vector<float64_t>>(key); }
     std::vector<std::string> get_vstring(const std::string &key) const { return get_value<std::vector<std::string>>(key); }
     std::vector<bool> get_vbool(const std::string &key) const { return get_value<std::vector<bool>>(key); }
+    // Zero-copy access: references are valid until the value is changed or the list is destroyed
+    template<typename T>
+    const T &get_value_ref(const std::string &key) const;
+    const std::string &get_string_ref(const std::string &key) const { return get_value_ref<std::string>(key); }
+    const std::vector<uint32_t> &get_vint_ref(const std::string &key) const { return get_value_ref<std::vector<uint32_t>>(key); }
+    const std::vector<float64_t> &get_vfloat_ref(const std::string &key) const { return get_value_ref<std::vector<float64_t>>(key); }
+    const std::vector<std::string> &get_vstring_ref(const std::string &key) const { return get_value_ref<std::vector<std::string>>(key); }
+    const std::vector<bool> &get_vbool_ref(const std::string &key) const { return get_value_ref<std::vector<bool>>(key); }
+
+    // ID-based access, the string-keyed functions above are thin wrappers over it
+    static param_id_t get_id(const std::string &key) { return symbols::get().find(key); }
+    template<typename T>
+    const T &get_value_ref(param_id_t id) const;
+    bool is_value_set(param_id_t id) const { return find_value(id) != nullptr; }
 
     bool is_value_set(const std::string &key) const;
+
+    // Typed access by compile-time keys, see params_schema.h
+    template<typename K>
+    const typename K::value_type &get() const;
+    template<typename K>
+    void set(const typename K::value_type &v);
+    template<typename K>
+    void change(const typename K::value_type &v);
+    template<typename K>
+    bool is_set() const { return find_value(K::id) != nullptr; }
+
+    // Family filtering: matching_families of the parameter vs. the family of the list
+    const param_mask &get_applicable_params() const;
+    bool is_param_applicable(const std::string &key) const;
     std::string get_value_as_string(const std::string &key) const;
     bool get_value_as_string(const std::string &key, std::string &result) const;
     template<typename T>
@@ -121,9 +227,45 @@ public:
 	template <typename T>
 	bool is_value_allowed(const std::string &key, T val);
 	bool is_value_allowed(const std::string &key, const value &p);
-    const std::map<std::string, value> &get_raw_list() const { return l; }
+    // Non-copying view of the values which are set, in the order of names. Items are
+    // (name, value) pairs of references, valid until the list is changed or destroyed.
+    class raw_list_view {
+    public:
+        using item = std::pair<const std::string &, const value &>;
+        class iterator {
+        public:
+            iterator(const entries_t *_l, size_t _pos) : l(_l), pos(_pos) { skip_unset(); }
+            item operator*() const { 
+                auto id = symbols::get().sorted()[pos];
+                return item(symbols::get().name(id), *(*l)[id]); 
+            }
+            iterator &operator++() { pos++; skip_unset(); return *this; }
+            bool operator==(const iterator &other) const { return pos == other.pos; }
+            bool operator!=(const iterator &other) const { return pos != other.pos; }
+        private:
+            void skip_unset() {
+                const auto &sorted = symbols::get().sorted();
+                while (l && pos < sorted.size() && !(*l)[sorted[pos]])
+                    pos++;
+            }
+            const entries_t *l;
+            size_t pos;
+        };
+        raw_list_view(const entries_t *_l) : l(_l) {}
+        iterator begin() const { return iterator(l, 0); }
+        iterator end() const { return iterator(l, l ? symbols::get().sorted().size() : 0); }
+        size_t size() const;
+        bool empty() const { return begin() == end(); }
+    private:
+        const entries_t *l;
+    };
+    raw_list_view get_raw_list() const { return raw_list_view(l.get()); }
+    // The same as an owning map: copies every value
+    std::map<std::string, value> copy_raw_list() const;
     bool erase();
     void print(const std::string &header = "");
+    // Formats the same table as print() into the buffer, without flushing it
+    void render(std::ostream &out, const std::string &header = "") const;
     void add_print_converter(const std::string &key, std::function<std::string(const value &)>);
     void remove_print_converter(const std::string &key);
 
@@ -133,20 +275,28 @@ protected:
     void print_line(const std::string &key, const std::string &out = "", bool omit_undefined = false) const;
 	static void print_header(const std::string str, uint16_t offset = 8);
 	static void print_line_delimiter();
+    void render_line(std::ostream &out, const std::string &key, const std::string &out_key = "", 
+                     bool omit_undefined = false) const;
+	static void render_header(std::ostream &out, const std::string &str, uint16_t offset = 8);
+	static void render_line_delimiter(std::ostream &out);
    
 public:
     friend struct dictionary<details>;
+    friend struct overrides_holder<details>;
     void set_default(const std::string &list_name);
 };
 
 }
 
 #include "params_override.h"
+#include "params_schema.h"
+#include "params_binder.h"
 
 namespace params {    
 
 template <class details>
 struct dictionary {
+    // NOTE: after inserting or erasing lists in m directly, call reindex()
     std::map<std::string, list<details>> m;
     void add(const std::string &name, const list<details> &list);
     void add_map(const std::string &name, const std::map<std::string, std::string> &kvmap);
@@ -167,10 +317,37 @@ struct dictionary {
     const list<details> &get_if(const std::vector<std::pair<std::string, T>> &conditions) const;
     template <typename T>
     list<details> &get_if(const std::vector<std::pair<std::string, T>> &conditions);
+    template <typename T>
+    bool find_if_all(const std::vector<std::pair<std::string, T>> &conditions, 
+                     std::string &found_list_name) const;
+    template <typename T>
+    bool find_if_all(const std::vector<std::pair<std::string, T>> &conditions) const;
+    template <typename T>
+    const list<details> &get_if_all(const std::vector<std::pair<std::string, T>> &conditions, 
+                                    std::string &found_list_name) const;
+    template <typename T>
+    list<details> &get_if_all(const std::vector<std::pair<std::string, T>> &conditions, 
+                              std::string &found_list_name);
+    template <typename T>
+    const list<details> &get_if_all(const std::vector<std::pair<std::string, T>> &conditions) const;
+    template <typename T>
+    list<details> &get_if_all(const std::vector<std::pair<std::string, T>> &conditions);
+    // Indexed lookups of find_if(), get_if() and get_if_all() see the changes made by the
+    // dictionary calls, and the changes made via a reference returned by non-const get(name)
+    // before the next lookup. A list changed via a reference kept across a lookup or across
+    // add_index() is not seen until get(name) is called on it again or reindex() is called.
+    void add_index(const std::string &key);
+    // Rebuilds the indexes and the positional cache, e.g. after lists were inserted into
+    // or erased from m directly
+    void reindex();
     list<details> &get(const std::string &name);
     const list<details> &get(const std::string &name) const;
     const std::string &get(size_t num) const;
     list<details> get(const std::string &name, int layer) const;
+    list<details> get_overrides(const std::string &name) const;
+    template<typename T>
+    std::vector<typename layer_value<T>::type> get_all_layers(const std::string &list_name, 
+                                                              const std::string &key) const;
     template<typename T>
     void change_value(const std::string &list_name, const std::string &key, const T &value);
     template<typename T>
@@ -181,14 +358,54 @@ struct dictionary {
     void forced_change_value_onlayer(const std::string &list_name, const std::string &key, const T &value, 
                                      uint16_t layer);
     protected:    
+    std::map<std::string, layer_overrides_t> onlayer_overrides;
     template<typename T>
     void internal_change_value_onlayer(const std::string &list_name, const std::string &key, 
                                        const T &value, uint16_t layer, bool forced);
+    bool fill_in_overrides(const std::string &name, overrides_holder<details> &holder) const;
+    // Secondary indexes: key -> value as string -> list names. Lists which were possibly 
+    // changed since the last query are kept in dirty_lists and reindexed lazily by the
+    // first const lookup, under caches_guard; the indexes are then read without locking.
+    using index_t = std::map<std::string, std::set<std::string>>;
+    mutable std::map<std::string, index_t> indexes;
+    mutable std::map<std::string, std::map<std::string, std::string>> indexed_values;
+    mutable std::set<std::string> dirty_lists;
+    void mark_dirty(const std::string &name) const;
+    void index_list(const std::string &name) const;
+    void refresh_indexes() const;
+    template <typename T>
+    bool match_conditions(const list<details> &l, const std::vector<std::pair<std::string, T>> &conditions, 
+                          bool match_all) const;
+    template <typename T>
+    const std::string *lookup(const std::vector<std::pair<std::string, T>> &conditions, bool match_all) const;
+    // Positional access to m: built lazily on the first get(size_t) after add(), add_map(),
+    // add_override() or reindex(). Copying a dictionary doesn't copy it, since it refers to
+    // the map nodes of the source.
+    struct positions_cache {
+        std::vector<typename std::map<std::string, list<details>>::const_iterator> positions;
+        bool valid = false;
+        positions_cache() {}
+        positions_cache(const positions_cache &) {}
+        positions_cache &operator=(const positions_cache &) { positions.clear(); valid = false; return *this; }
+    };
+    mutable positions_cache by_position;
+    // Guards the lazily built caches, so that const calls may be made concurrently
+    struct cache_mutex {
+        std::mutex mtx;
+        cache_mutex() {}
+        cache_mutex(const cache_mutex &) {}
+        cache_mutex &operator=(const cache_mutex &) { return *this; }
+    };
+    mutable cache_mutex caches_guard;
     
     public:
     void print() const;
     void set_defaults();
+    void set_defaults(size_t nthreads);
     void print_list(const std::string &list_name, const std::string &header_name, bool omit_undefined = false) const;
+    // Formats the same table as print_list() into the buffer, without flushing it
+    void render_list(std::ostream &out, const std::string &list_name, const std::string &header_name, 
+                     bool omit_undefined = false) const;
     size_t size() const;
 };
 
@@ -197,4 +414,5 @@ struct dictionary {
 #include "list.inl"
 #include "dict.inl" 
 #include "override.inl"
+#include "binder.inl"
 
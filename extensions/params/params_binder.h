@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020-2024 Alexey V. Medvedev, Boris Krasnopolsky
+ * This code is licensed under 3-Clause BSD license.
+ * See license.txt file for details.
+ */
+
+#pragma once
+
+namespace params {
+
+// Binds members of a plain user struct S to parameter keys, so that a parameter block
+// for a hot loop is filled in from a list with a single fill() call. Key names and types
+// are resolved once in bind(), fill() does only ID-indexed loads and typed assignments.
+template <class details, class S>
+class binder {
+public:
+    template<typename T>
+    binder &bind(const std::string &key, T S::*member, bool required = true);
+    template<typename K>
+    binder &bind(typename K::value_type S::*member, bool required = true);
+    void fill(const list<details> &l, S &target) const;
+    S fill(const list<details> &l) const { S target; fill(l, target); return target; }
+    void fill(const dictionary<details> &dict, const std::string &list_name, int layer, S &target) const;
+    size_t size() const;
+
+protected:
+    template<typename T>
+    struct binding {
+        param_id_t id;
+        T S::*member;
+        bool required;
+    };
+    template<typename T>
+    using bindings_t = std::vector<binding<T>>;
+    bindings_t<uint32_t> ints;
+    bindings_t<float64_t> floats;
+    bindings_t<std::string> strings;
+    bindings_t<bool> bools;
+    bindings_t<std::vector<uint32_t>> ivecs;
+    bindings_t<std::vector<float64_t>> fvecs;
+    bindings_t<std::vector<std::string>> svecs;
+    bindings_t<std::vector<bool>> bvecs;
+    bindings_t<uint32_t> &get_bindings(const uint32_t *) { return ints; }
+    bindings_t<float64_t> &get_bindings(const float64_t *) { return floats; }
+    bindings_t<std::string> &get_bindings(const std::string *) { return strings; }
+    bindings_t<bool> &get_bindings(const bool *) { return bools; }
+    bindings_t<std::vector<uint32_t>> &get_bindings(const std::vector<uint32_t> *) { return ivecs; }
+    bindings_t<std::vector<float64_t>> &get_bindings(const std::vector<float64_t> *) { return fvecs; }
+    bindings_t<std::vector<std::string>> &get_bindings(const std::vector<std::string> *) { return svecs; }
+    bindings_t<std::vector<bool>> &get_bindings(const std::vector<bool> *) { return bvecs; }
+    template<typename T>
+    static void fill_in(const bindings_t<T> &bindings, const list<details> &l, S &target);
+};
+
+}
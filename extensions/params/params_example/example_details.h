@@ -23,13 +23,15 @@ struct example_params_details {
     }
 
     static void print_table(const my_dictionary &params) {
-	    my_list::print_line_delimiter();
-    	my_list::print_header("EXAMPLE set of params");
+        std::stringstream ss;
+	    my_list::render_line_delimiter(ss);
+    	my_list::render_header(ss, "EXAMPLE set of params");
         auto size = params.size();
         for (size_t i = 0; i < size; i++) {
             auto &l = params.get(i);
-            params.print_list(l, l);
+            params.render_list(ss, l, l);
         }
+        print_stream(ss);
     }
 
 
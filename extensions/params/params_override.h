@@ -13,17 +13,28 @@ namespace params {
 
 template <class details> class list;
 
+// On-layer override record: a typed value applied to layers [start, end].
+struct layer_override {
+    value v;
+    size_t start;
+    size_t end;
+};
+
+using layer_overrides_t = std::map<std::string, std::vector<layer_override>>;
+
 template <class details>
 struct overrides_holder {
     std::map<size_t, list<details>> per_layer_lists;
     const size_t nlayers;
     void get_start_end_layer(const std::string &s, size_t &start, size_t &end);
+    void get_part(const std::string &part, std::string &v, size_t &start, size_t &end);
     overrides_holder(size_t _nlayers) : nlayers(_nlayers) {}
     void fill_in(const list<details> &in);
+    void fill_in(const layer_overrides_t &in);
     bool find(size_t layer);
     list<details> &get(size_t layer);
     template <typename T>
-    void apply_for_each_layer(const std::string &param_name, std::function<void (T, uint8_t)> f);
+    void apply_for_each_layer(const std::string &param_name, std::function<void (T, size_t)> f);
 };
 
 }
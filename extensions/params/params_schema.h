@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020-2024 Alexey V. Medvedev, Boris Krasnopolsky
+ * This code is licensed under 3-Clause BSD license.
+ * See license.txt file for details.
+ */
+
+#pragma once
+
+#include <type_traits>
+
+/*
+ * Compile-time params schema. The set of expected params is declared once as an X-macro:
+ *
+ *   #define MY_PARAMS(X) \
+ *       X(family,  "family",  S, false, (),              (),         ("a", "b")) \
+ *       X(float_,  "float",   F, true,  ("a"),           (),         ()) \
+ *       X(integer, "integer", I, true,  (),              ("1", "3"), ())
+ *   PARAMS_SCHEMA(my_schema, MY_PARAMS)
+ *
+ * The columns are: C++ identifier, parameter name, value type, changeable flag,
+ * (matching families), (min, max), (allowed values). This generates the struct my_schema
+ * with the runtime table my_schema::get_expected_params() and a key type for each parameter:
+ * my_schema::integer etc. The details class refers to the schema as
+ *
+ *   using schema = my_schema;
+ *   static const params::expected_params_t &get_expected_params() { return schema::get_expected_params(); }
+ *
+ * and then list.get<my_schema::integer>() resolves slot and type at compile time.
+ */
+
+namespace params {
+
+template <value::type_t> struct value_type_of;
+template <> struct value_type_of<value::I> { using type = uint32_t; };
+template <> struct value_type_of<value::F> { using type = float64_t; };
+template <> struct value_type_of<value::S> { using type = std::string; };
+template <> struct value_type_of<value::B> { using type = bool; };
+template <> struct value_type_of<value::IV> { using type = std::vector<uint32_t>; };
+template <> struct value_type_of<value::FV> { using type = std::vector<float64_t>; };
+template <> struct value_type_of<value::SV> { using type = std::vector<std::string>; };
+template <> struct value_type_of<value::BV> { using type = std::vector<bool>; };
+
+template <class SCHEMA, param_id_t ID, value::type_t TYPE, bool CHANGEABLE, bool CONSTRAINED>
+struct key {
+    using schema = SCHEMA;
+    using value_type = typename value_type_of<TYPE>::type;
+    static constexpr param_id_t id = ID;
+    static constexpr value::type_t type = TYPE;
+    static constexpr bool changeable = CHANGEABLE;
+    // min/max or allowed values are given, so the values are to be checked on set
+    static constexpr bool constrained = CONSTRAINED;
+};
+
+template <class SCHEMA, param_id_t ID, value::type_t TYPE, bool CHANGEABLE, bool CONSTRAINED>
+constexpr param_id_t key<SCHEMA, ID, TYPE, CHANGEABLE, CONSTRAINED>::id;
+template <class SCHEMA, param_id_t ID, value::type_t TYPE, bool CHANGEABLE, bool CONSTRAINED>
+constexpr value::type_t key<SCHEMA, ID, TYPE, CHANGEABLE, CONSTRAINED>::type;
+template <class SCHEMA, param_id_t ID, value::type_t TYPE, bool CHANGEABLE, bool CONSTRAINED>
+constexpr bool key<SCHEMA, ID, TYPE, CHANGEABLE, CONSTRAINED>::changeable;
+template <class SCHEMA, param_id_t ID, value::type_t TYPE, bool CHANGEABLE, bool CONSTRAINED>
+constexpr bool key<SCHEMA, ID, TYPE, CHANGEABLE, CONSTRAINED>::constrained;
+
+namespace helpers {
+
+template <typename... ARGS>
+constexpr size_t nargs(ARGS...) { return sizeof...(ARGS); }
+
+}
+
+}
+
+#define PARAMS_SCHEMA_VEC(...) { __VA_ARGS__ }
+#define PARAMS_SCHEMA_NARGS(...) params::helpers::nargs(__VA_ARGS__)
+
+#define PARAMS_SCHEMA_ID(ident, name, type, changeable, families, minmax, allowed) ident,
+
+#define PARAMS_SCHEMA_KEY(ident, name, type, changeable, families, minmax, allowed) \
+    struct ident : params::key<schema_t, ids::ident, params::value::type, changeable, \
+                               (PARAMS_SCHEMA_NARGS minmax + PARAMS_SCHEMA_NARGS allowed > 0)> { \
+        static const char *name_str() { return name; } \
+    };
+
+#define PARAMS_SCHEMA_ENTRY(ident, name, type, changeable, families, minmax, allowed) \
+    { name, { params::value::type, changeable, PARAMS_SCHEMA_VEC families, PARAMS_SCHEMA_VEC minmax, \
+              PARAMS_SCHEMA_VEC allowed } },
+
+#define PARAMS_SCHEMA(schema_name, ITEMS) \
+    struct schema_name { \
+        using schema_t = schema_name; \
+        struct ids { enum : params::param_id_t { ITEMS(PARAMS_SCHEMA_ID) nparams }; }; \
+        ITEMS(PARAMS_SCHEMA_KEY) \
+        static const params::expected_params_t &get_expected_params() { \
+            static const params::expected_params_t expected_params = { ITEMS(PARAMS_SCHEMA_ENTRY) }; \
+            return expected_params; \
+        } \
+    };
@@ -9,18 +9,52 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <thread>
+#include <type_traits>
 
 #include "params.h"
 #include "params.inl"
 #include "utest_details.h"
 
 #include <argsparser.h>
+#include "yamlassist.inl"
+#include "yamlstream.inl"
 
 bool utest_params_details::use_debug_print_tables = false;
+uint16_t utest_params_details::nlayers = 100;
+std::string *utest_params_details::captured_output = nullptr;
+size_t utest_params_details::nflushes = 0;
+
+// Live heap bytes counter for memory footprint checks
+static std::atomic<size_t> heap_bytes_in_use(0);
+static std::atomic<size_t> heap_bytes_peak(0);
+
+void *operator new(size_t size) {
+    size_t *p = (size_t *)malloc(size + sizeof(max_align_t));
+    if (!p)
+        throw std::bad_alloc();
+    *p = size;
+    size_t in_use = (heap_bytes_in_use += size);
+    size_t peak = heap_bytes_peak.load();
+    while (in_use > peak && !heap_bytes_peak.compare_exchange_weak(peak, in_use)) {}
+    return (char *)p + sizeof(max_align_t);
+}
+
+void operator delete(void *ptr) noexcept {
+    if (!ptr)
+        return;
+    size_t *p = (size_t *)((char *)ptr - sizeof(max_align_t));
+    heap_bytes_in_use -= *p;
+    free(p);
+}
 
 using utest_dictionary = params::dictionary<utest_params_details>;
 using utest_list = params::list<utest_params_details>;
 using utest_overrides_holder = params::overrides_holder<utest_params_details>;
+using utest_schema_dictionary = params::dictionary<utest_schema_details>;
 
 static inline std::vector<std::string> str_split(const std::string &s, char delimiter)
 {
@@ -255,6 +289,825 @@ void testsuite_10(int argc, char **argv)
 	}
 }
 
+void testsuite_11(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    utest_dictionary params;
+    params.add_override("qux", {{"aaa", "5@lev3"}});
+    params.set_defaults();
+    for (int level = 2; level < 5; level++) {
+        params.change_value_onlayer<uint32_t>("qux", "ddd", 5555, level);
+    }
+    params.change_value_onlayer<uint32_t>("qux", "aaa", 7, 3);
+    assert(params.get("qux", 1).get_int("ddd") == 777);
+    assert(params.get("qux", 3).get_int("ddd") == 5555);
+    assert(params.get("qux", 3).get_int("aaa") == 7);
+    assert(params.get("qux", 4).get_int("aaa") == 56);
+    auto overrides = params.get_overrides("qux");
+    assert(overrides.get_value_as_string("ddd") == "5555@lev2;5555@lev3;5555@lev4");
+    assert(overrides.get_value_as_string("aaa") == "5@lev3;7@lev3");
+    // on-layer changes are rendered as a part of the "_override" list
+    assert(params.find("qux_override"));
+    std::stringstream rendered;
+    params.render_list(rendered, "qux_override", "");
+    assert(rendered.str().find("5555@lev2;5555@lev3;5555@lev4") != std::string::npos);
+    // textual overrides edited later go first, on-layer changes are still applied over them
+    params::value text;
+    text.set<std::string>("9@lev3;9@lev4");
+    params.get("qux_override").set("aaa", text);
+    assert(params.get("qux", 3).get_int("aaa") == 7 && params.get("qux", 4).get_int("aaa") == 9);
+    assert(params.get_all_layers<uint32_t>("qux", "aaa")[3] == 7);
+    params.change_value_onlayer<uint32_t>("qux", "aaa", 8, 4);
+    assert(params.get_overrides("qux").get_value_as_string("aaa") == "9@lev3;9@lev4;7@lev3;8@lev4");
+    assert(params.get("qux", 4).get_int("aaa") == 8);
+    bool except = false;
+    try {
+        params.change_value_onlayer<uint32_t>("qux", "hhh", 2, 1);
+    }
+    catch (std::runtime_error &) {
+        except = true;
+    }
+    assert(except);
+    params.forced_change_value_onlayer<uint32_t>("qux", "hhh", 3, 1);
+    assert(params.get("qux", 1).get_int("hhh") == 3);
+}
+
+void testsuite_12(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    utest_params_details::nlayers = 3000;
+    utest_dictionary params;
+    params.add_override("baz", {{"aaa", "5@lev3;6@lev10-20"}});
+    params.set_defaults();
+    params.change_value_onlayer<uint32_t>("baz", "aaa", 7, 15);
+    params.change_value_onlayer<uint32_t>("baz", "aaa", 8, 2999);
+    auto aaa = params.get_all_layers<uint32_t>("baz", "aaa");
+    assert(aaa.size() == 3000);
+    for (size_t layer = 0; layer < aaa.size(); layer++) {
+        assert(aaa[layer] == params.get("baz", layer).get_int("aaa"));
+    }
+    assert(aaa[0] == 56 && aaa[3] == 5 && aaa[10] == 6 && aaa[15] == 7 && aaa[21] == 56 && aaa[2999] == 8);
+    auto bbb = params.get_all_layers<float64_t>("baz", "bbb");
+    assert(bbb.size() == 3000 && bbb[1000] == 1.234);
+    // bool values come as a contiguous array of bytes
+    static_assert(std::is_same<decltype(params.get_all_layers<bool>("baz", "")), std::vector<uint8_t>>::value,
+                  "get_all_layers<bool> must not return std::vector<bool>");
+    // no base value: fine as long as overrides give it on every layer
+    params.add_override("qux", {{"ccc", "1.5@lev0-E"}});
+    params.forced_change_value_onlayer<float64_t>("qux", "ccc", 2.5, 7);
+    auto ccc = params.get_all_layers<float64_t>("qux", "ccc");
+    assert(ccc[0] == 1.5 && ccc[7] == 2.5 && ccc[2999] == 1.5);
+    params.forced_change_value_onlayer<float64_t>("baz", "ccc", 2.5, 7);
+    bool except = false;
+    try {
+        params.get_all_layers<float64_t>("baz", "ccc");
+    }
+    catch (std::runtime_error &) {
+        except = true;
+    }
+    assert(except);
+    utest_params_details::nlayers = 100;
+}
+
+void testsuite_13(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    constexpr size_t N = 3000;
+    utest_dictionary params, indexed;
+    const std::vector<std::string> families = { "xxx", "yyy", "zzz" };
+    for (size_t i = 0; i < N; i++) {
+        auto name = std::string("list") + std::to_string(i);
+        utest_list l { "family", families[i % families.size()] };
+        l.add_value<uint32_t>("aaa", i);
+        params.add(name, l);
+        indexed.add(name, l);
+    }
+    indexed.add_index("family");
+    indexed.add_index("aaa");
+    std::string found, expected;
+    for (uint32_t v : { 0, 5, 99, 2999, 3000 }) {
+        bool r1 = params.find_if<uint32_t>({{"aaa", v}, {"ddd", 1}}, expected);
+        bool r2 = indexed.find_if<uint32_t>({{"aaa", v}, {"ddd", 1}}, found);
+        assert(r1 == r2 && (!r1 || found == expected));
+    }
+    assert(indexed.find_if_all<std::string>({{"family", "yyy"}}, found) && found == "list1");
+    assert(!indexed.find_if_all<uint32_t>({{"aaa", 5}, {"hhh", 1}}));
+    assert(indexed.find_if<std::string>({{"family", "zzz"}, {"family", "yyy"}}, found) && found == "list1");
+    // a condition of another type than the parameter doesn't match
+    assert(!params.find_if<std::string>({{"aaa", "50"}}));
+    assert(!indexed.find_if<std::string>({{"aaa", "50"}}));
+    indexed.change_value<uint32_t>("list1", "aaa", 1000);
+    assert(indexed.get_if_all<uint32_t>({{"aaa", 1000}}, found).get_int("aaa") == 1000 && found == "list1");
+    indexed.get("list2").parse_and_set_value("aaa", "2000");
+    assert(indexed.find_if<uint32_t>({{"aaa", 2000}}, found) && found == "list2");
+    assert(!indexed.find_if<uint32_t>({{"aaa", 2}}, found));
+    // const lookups go concurrently, the first of them reindexes the changed lists
+    for (size_t i = 0; i < 100; i++)
+        indexed.get("list" + std::to_string(i)).parse_and_set_value("aaa", std::to_string(5000 + i));
+    const auto &shared = indexed;
+    std::vector<std::thread> readers;
+    std::atomic<size_t> nfound(0);
+    for (size_t t = 0; t < 4; t++) {
+        readers.emplace_back([&shared, &nfound]() {
+            for (uint32_t v = 5000; v < 5100; v++)
+                nfound += shared.find_if<uint32_t>({{"aaa", v}}) ? 1 : 0;
+        });
+    }
+    for (auto &r : readers)
+        r.join();
+    assert(nfound == 400);
+    // a reference kept across a lookup needs reindex()
+    auto &kept = indexed.get("list200");
+    assert(indexed.find_if<uint32_t>({{"aaa", 200}}));
+    kept.parse_and_set_value("aaa", "6000");
+    indexed.reindex();
+    assert(indexed.find_if<uint32_t>({{"aaa", 6000}}, found) && found == "list200");
+    using namespace std::chrono;
+    constexpr size_t NQ = 1000;
+    for (auto d : { &params, &indexed }) {
+        auto before  = steady_clock::now();
+        for (size_t i = 0; i < NQ; i++) {
+            d->find_if<uint32_t>({{"aaa", (uint32_t)(N - 1 - i % 100)}});
+        }
+        auto after = steady_clock::now();
+        double duration = duration_cast<microseconds>(after - before).count();
+        std::cout << ">> USECS per single find_if call (" << (d == &params ? "no index" : "indexed") << "): " 
+                  << duration / (double)NQ << std::endl;
+    }
+}
+
+void testsuite_14(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    constexpr size_t N = 10000;
+    utest_dictionary params;
+    for (size_t i = 0; i < N; i++) {
+        params.add(std::string("list") + std::to_string(i), { "family", "xxx" });
+    }
+    using namespace std::chrono;
+    auto before  = steady_clock::now();
+    size_t nchars = 0;
+    for (size_t i = 0; i < params.size(); i++) {
+        auto &name = params.get(i);
+        nchars += params.get(name).get_string("family").size();
+    }
+    auto after = steady_clock::now();
+    assert(nchars == 3 * N);
+    size_t first = 0, second = 1, last = N - 1;
+    assert(params.get(first) == "list0" && params.get(last) == "list9999");
+    params.add("list", { "family", "yyy" });
+    assert(params.get(first) == "list" && params.get(second) == "list0");
+    // direct changes of m are followed by reindex()
+    params.m.erase("list0");
+    params.m.insert(std::make_pair(std::string("list00"), params.get("list1")));
+    params.reindex();
+    assert(params.get(second) == "list00");
+    double duration = duration_cast<microseconds>(after - before).count();
+    std::cout << ">> USECS per indexed enumeration of " << N << " lists: " << duration << std::endl;
+}
+
+void testsuite_15(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    size_t max_member = std::max({ sizeof(uint32_t), sizeof(float64_t), sizeof(bool), sizeof(std::string), 
+            sizeof(std::vector<uint32_t>), sizeof(std::vector<float64_t>), sizeof(std::vector<bool>), 
+            sizeof(std::vector<std::string>) });
+    assert(sizeof(params::value) <= max_member + sizeof(params::value::type_t) + alignof(params::value));
+    constexpr size_t N = 10000;
+    size_t before = heap_bytes_in_use;
+    {
+        utest_dictionary params;
+        for (size_t i = 0; i < N; i++) {
+            params.add(std::string("list") + std::to_string(i), { "family", "xxx" });
+        }
+        params.set_defaults();
+        size_t bytes = heap_bytes_in_use - before;
+        std::cout << ">> BYTES per value: " << sizeof(params::value) << std::endl;
+        std::cout << ">> BYTES per list of " << params.get("list0").get_raw_list().size() << " values: " << bytes / N << std::endl;
+        assert(bytes / N < 1536);
+    }
+    assert(heap_bytes_in_use == before);
+}
+
+void testsuite_16(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    constexpr size_t N = 1000000;
+    utest_list list { "family", "xxx" };
+    list.add_value<std::vector<float64_t>>("fvec", std::vector<float64_t>(N, 0.5));
+    const auto &fvec = list.get_vfloat_ref("fvec");
+    assert(fvec.size() == N && &fvec == &list.get_vfloat_ref("fvec"));
+    assert(list.get_string_ref("family") == "xxx");
+    bool except = false;
+    try {
+        list.get_vint_ref("fvec");
+    }
+    catch (std::runtime_error &) {
+        except = true;
+    }
+    assert(except);
+    using namespace std::chrono;
+    constexpr size_t NQ = 100;
+    double sum = 0;
+    auto before  = steady_clock::now();
+    for (size_t i = 0; i < NQ; i++) {
+        sum += list.get_vfloat("fvec")[i];
+    }
+    auto middle = steady_clock::now();
+    for (size_t i = 0; i < NQ; i++) {
+        sum += list.get_vfloat_ref("fvec")[i];
+    }
+    auto after = steady_clock::now();
+    assert(sum == NQ);
+    std::cout << ">> USECS per get_vfloat call (" << N << " elements): " 
+              << duration_cast<microseconds>(middle - before).count() / (double)NQ << std::endl;
+    std::cout << ">> USECS per get_vfloat_ref call (" << N << " elements): " 
+              << duration_cast<microseconds>(after - middle).count() / (double)NQ << std::endl;
+}
+
+void testsuite_17(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    constexpr size_t N = 2000;
+    std::stringstream ss;
+    ss << "common:\n  dict:\n";
+    for (size_t i = 0; i < N; i++) {
+        ss << "    list" << i << ":\n"
+           << "      family: " << (i % 2 ? "xxx" : "yyy") << "\n"
+           << "      aaa: " << i << "\n"
+           << "      ivec: [ 1, 2, " << i << " ]\n"
+           << "      fvec: [ 1.5, -2e-3 ]\n"
+           << "      svec: [ uno, dos ]\n"
+           << "      bvec: [ true, off ]\n";
+    }
+    YAML::Node stream = YAML::Load(ss.str());
+    params::yaml_read_assistant<utest_params_details> reader(stream);
+    utest_dictionary params;
+    using namespace std::chrono;
+    auto before  = steady_clock::now();
+    bool found = reader.get_all_lists("common/dict/", params);
+    auto after = steady_clock::now();
+    assert(found && params.size() == N);
+    assert(!reader.get_all_lists("common/nodict/", params));
+    utest_dictionary expected;
+    auto middle = steady_clock::now();
+    std::vector<std::string> keys;
+    reader.get_map_keys("common/dict/", keys);
+    for (const auto &key : keys) {
+        reader.get_list("common/dict/" + key, expected);
+    }
+    auto end = steady_clock::now();
+    assert(expected.size() == N);
+    auto &l = params.get("list7");
+    auto &e = expected.get("list7");
+    assert(l.get_string("family") == e.get_string("family") && l.get_int("aaa") == 7);
+    assert(l.get_vint_ref("ivec") == e.get_vint_ref("ivec") && l.get_vint_ref("ivec")[2] == 7);
+    assert(l.get_vfloat_ref("fvec") == e.get_vfloat_ref("fvec"));
+    assert(l.get_vstring_ref("svec") == e.get_vstring_ref("svec"));
+    assert(l.get_vbool_ref("bvec") == e.get_vbool_ref("bvec") && !l.get_vbool_ref("bvec")[1]);
+    std::cout << ">> USECS per get_all_lists call (" << N << " lists): " 
+              << duration_cast<microseconds>(after - before).count() << std::endl;
+    std::cout << ">> USECS per get_list calls for all keys (" << N << " lists): " 
+              << duration_cast<microseconds>(end - middle).count() << std::endl;
+}
+
+void testsuite_18(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    constexpr size_t N = 5000;
+    std::stringstream ss;
+    ss << "---\nversion: 1\nother:\n  big:\n";
+    for (size_t i = 0; i < N; i++) {
+        ss << "    list" << i << ": { family: xxx, aaa: " << i << ", ivec: [ 1, 2, 3 ], svec: [ a, b ] }\n";
+    }
+    ss << "common:\n  skipped: [ 1, { a: b }, [ c ] ]\n  dict:\n";
+    for (size_t i = 0; i < 10; i++) {
+        ss << "    list" << i << ":\n      family: yyy\n      ddd: " << i << "\n"
+           << "      fvec: [ 1.5, -2e-3 ]\n      bvec: [ true, off ]\n";
+    }
+    ss << "  empty:\n...\n";
+    const std::string doc = ss.str();
+    utest_dictionary streamed, loaded;
+    params::yaml_stream_reader<utest_params_details> stream_reader;
+    std::istringstream in1(doc);
+    size_t base = heap_bytes_in_use;
+    heap_bytes_peak = base;
+    assert(stream_reader.get_all_lists(in1, "common/dict/", streamed));
+    size_t streamed_peak = heap_bytes_peak - base;
+    std::istringstream in2(doc);
+    base = heap_bytes_in_use;
+    heap_bytes_peak = base;
+    {
+        YAML::Node stream = YAML::Load(in2);
+        params::yaml_read_assistant<utest_params_details> reader(stream);
+        assert(reader.get_all_lists("common/dict/", loaded));
+    }
+    size_t loaded_peak = heap_bytes_peak - base;
+    assert(streamed.size() == 10 && loaded.size() == 10);
+    for (size_t i = 0; i < 10; i++) {
+        auto name = std::string("list") + std::to_string(i);
+        auto &l1 = streamed.get(name);
+        auto &l2 = loaded.get(name);
+        assert(l1.get_raw_list().size() == l2.get_raw_list().size());
+        assert(l1.get_int("ddd") == i && l1.get_int("ddd") == l2.get_int("ddd"));
+        assert(l1.get_vfloat_ref("fvec") == l2.get_vfloat_ref("fvec"));
+        assert(l1.get_vbool_ref("bvec") == l2.get_vbool_ref("bvec"));
+    }
+    std::istringstream in3(doc);
+    utest_dictionary empty;
+    assert(!stream_reader.get_all_lists(in3, "common/empty/", empty) && empty.size() == 0);
+    std::istringstream in4(doc);
+    assert(!stream_reader.get_all_lists(in4, "common/nodict/", empty));
+    std::istringstream in5(doc);
+    assert(stream_reader.get_all_lists(in5, "other/big/", empty) && empty.size() == N);
+    std::cout << ">> BYTES peak heap for streamed load of 10 of " << N + 10 << " lists: " << streamed_peak << std::endl;
+    std::cout << ">> BYTES peak heap for YAML::Load of 10 of " << N + 10 << " lists: " << loaded_peak << std::endl;
+    assert(streamed_peak < loaded_peak / 10);
+}
+
+void testsuite_19(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    using namespace std::chrono;
+    constexpr size_t N = 20000;
+    const std::vector<std::string> families = { "xxx", "yyy", "zzz" };
+    utest_dictionary source;
+    for (size_t i = 0; i < N; i++) {
+        std::stringstream name;
+        name << "list" << std::setw(5) << std::setfill('0') << i;
+        source.add(name.str(), utest_list { "family", families[i % families.size()] });
+    }
+    utest_dictionary reference = source;
+    reference.set_defaults();
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        utest_dictionary params = source;
+        auto before = steady_clock::now();
+        params.set_defaults(nthreads);
+        auto after = steady_clock::now();
+        double duration = duration_cast<microseconds>(after - before).count();
+        std::cout << ">> USECS per set_defaults(" << nthreads << ") call (" << N << " lists): " 
+                  << duration << std::endl;
+        assert(params.size() == reference.size());
+        for (auto &i : reference.m) {
+            assert(params.get(i.first).get_raw_list().size() == i.second.get_raw_list().size());
+        }
+        assert(params.find_if<std::string>({{"family", "zzz"}}));
+    }
+    // Two broken lists: the error of the first one in map order must always win
+    utest_list no_family;
+    source.add("list01000a", no_family);
+    utest_list int_family;
+    params::value v;
+    v.set<uint32_t>(1);
+    int_family.set("family", v);
+    source.add("list00100a", int_family);
+    for (size_t nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        utest_dictionary params = source;
+        std::string error;
+        try {
+            params.set_defaults(nthreads);
+        }
+        catch (std::runtime_error &e) {
+            error = e.what();
+        }
+        assert(error == "params: get_value: type mismatch on a parameter: family");
+    }
+}
+
+void testsuite_20(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    using symbols = params::symbol_table<utest_params_details>;
+    const auto &expected_params = utest_params_details::get_expected_params();
+    assert(symbols::get().size() == expected_params.size());
+    for (size_t i = 0; i < expected_params.size(); i++) {
+        assert(utest_list::get_id(expected_params[i].first) == i);
+        assert(symbols::get().name(i) == expected_params[i].first);
+    }
+    assert(utest_list::get_id("unknown") == symbols::npos);
+    utest_list list { "family", "xxx" };
+    list.add_value<uint32_t>("aaa", 10);
+    list.add_value<float64_t>("bbb", 2.5);
+    auto aaa = utest_list::get_id("aaa");
+    assert(list.is_value_set(aaa) && !list.is_value_set(utest_list::get_id("ddd")));
+    assert(list.get_value_ref<uint32_t>(aaa) == 10);
+    auto raw = list.get_raw_list();
+    std::vector<std::string> names;
+    for (const auto &i : raw)
+        names.push_back(i.first);
+    assert(raw.size() == 3 && names.size() == 3 && names.front() == "aaa" && names.back() == "family");
+    assert((*raw.begin()).second.as_string() == "10");
+    auto copied = list.copy_raw_list();
+    assert(copied.size() == 3 && copied.begin()->first == "aaa" && copied.rbegin()->first == "family");
+    bool thrown = false;
+    try {
+        list.get_value_ref<std::string>(aaa);
+    }
+    catch (std::runtime_error &e) {
+        thrown = (std::string(e.what()) == "params: get_value: type mismatch on a parameter: aaa");
+    }
+    assert(thrown);
+    list.add_print_converter("bbb", [](const params::value &) { return std::string("converted"); });
+    assert(list.get_value_as_string("bbb") == "converted" && list.get_value_as_string("aaa") == "10");
+    list.remove_print_converter("bbb");
+    assert(list.get_value_as_string("bbb") != "converted");
+    using namespace std::chrono;
+    constexpr size_t N = 1000000;
+    uint64_t sum = 0;
+    auto before = steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        sum += list.get_int("aaa");
+    }
+    auto middle = steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        sum += list.get_value_ref<uint32_t>(aaa);
+    }
+    auto after = steady_clock::now();
+    assert(sum == 2 * N * 10);
+    double by_name = duration_cast<nanoseconds>(middle - before).count();
+    double by_id = duration_cast<nanoseconds>(after - middle).count();
+    std::cout << ">> USECS per get_int call by name: " << by_name / 1000.0 / N << std::endl;
+    std::cout << ">> USECS per get_value_ref call by ID: " << by_id / 1000.0 / N << std::endl;
+}
+
+void testsuite_21(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    static_assert(utest_schema::aaa::id == 1 && utest_schema::aaa::type == params::value::I, "schema: wrong key");
+    static_assert(std::is_same<utest_schema::fvec::value_type, std::vector<float64_t>>::value, "schema: wrong type");
+    static_assert(utest_schema::hhh::constrained && utest_schema::iii::constrained && !utest_schema::aaa::constrained, 
+                  "schema: wrong constraints flag");
+    static_assert(!utest_schema::family::changeable && utest_schema::ddd::changeable, "schema: wrong changeable flag");
+    const auto &expected_params = utest_schema_details::get_expected_params();
+    assert(expected_params.size() == utest_schema::ids::nparams);
+    assert(expected_params[utest_schema::hhh::id].first == "hhh");
+    assert(expected_params[utest_schema::hhh::id].second.matching_families == std::vector<std::string> { "!yyy" });
+    assert(expected_params[utest_schema::eee::id].second.allowed_values.size() == 3);
+    // the schema yields the same table as the hand-written one
+    const auto &written = utest_params_details::get_expected_params();
+    assert(written.size() == expected_params.size());
+    for (size_t id = 0; id < written.size(); id++) {
+        const auto &a = written[id], &b = expected_params[id];
+        assert(a.first == b.first && a.second.type == b.second.type && a.second.changeable == b.second.changeable);
+        assert(a.second.matching_families == b.second.matching_families);
+        assert(a.second.minmax == b.second.minmax && a.second.allowed_values == b.second.allowed_values);
+    }
+    utest_schema_dictionary params;
+    params.set_defaults();
+    auto &foo = params.get("foo");
+    assert(foo.get<utest_schema::aaa>() == foo.get_int("aaa"));
+    assert(foo.get<utest_schema::family>() == "xxx");
+    foo.change<utest_schema::aaa>(77);
+    assert(foo.get_int("aaa") == 77);
+    foo.set<utest_schema::fvec>({ 1.5, 2.5 });
+    assert(foo.get_vfloat("fvec").size() == 2 && foo.is_set<utest_schema::fvec>());
+    assert(!foo.is_set<utest_schema::ddd>());
+    bool thrown = false;
+    try {
+        foo.get<utest_schema::ddd>();
+    }
+    catch (std::runtime_error &e) {
+        thrown = (std::string(e.what()) == "params: get_value: unknown parameter or parameter is not set: ddd");
+    }
+    assert(thrown);
+    thrown = false;
+    try {
+        foo.set<utest_schema::hhh>(4);
+    }
+    catch (std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown && foo.get<utest_schema::hhh>() == 2);
+    using namespace std::chrono;
+    constexpr size_t N = 1000000;
+    uint64_t sum = 0;
+    auto before = steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        sum += foo.get<utest_schema::aaa>();
+    }
+    auto after = steady_clock::now();
+    assert(sum == 77 * N);
+    double duration = duration_cast<nanoseconds>(after - before).count();
+    std::cout << ">> USECS per get<key> call: " << duration / 1000.0 / N << std::endl;
+}
+
+struct solver_block {
+    uint32_t aaa = 0;
+    float64_t bbb = 0;
+    std::string eee;
+    std::vector<float64_t> fvec;
+    uint32_t ddd = 12345;
+};
+
+void testsuite_22(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    params::binder<utest_schema_details, solver_block> binder;
+    binder.bind("aaa", &solver_block::aaa)
+          .bind("bbb", &solver_block::bbb)
+          .bind<utest_schema::eee>(&solver_block::eee)
+          .bind<utest_schema::fvec>(&solver_block::fvec, false)
+          .bind("ddd", &solver_block::ddd, false);
+    assert(binder.size() == 5);
+    bool thrown = false;
+    try {
+        binder.bind("eee", &solver_block::aaa);
+    }
+    catch (std::runtime_error &e) {
+        thrown = (std::string(e.what()) == "params: binder: type mismatch on a parameter: eee");
+    }
+    assert(thrown && binder.size() == 5);
+    thrown = false;
+    try {
+        binder.bind("xyz", &solver_block::aaa);
+    }
+    catch (std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+    utest_schema_dictionary params;
+    params.set_defaults();
+    params.change_value_onlayer<uint32_t>("foo", "aaa", 99, 3);
+    auto block = binder.fill(params.get("foo"));
+    assert(block.aaa == 56 && block.bbb == 1.234 && block.eee == "test2");
+    assert(block.fvec.empty() && block.ddd == 12345);
+    binder.fill(params, "foo", 3, block);
+    assert(block.aaa == 99);
+    binder.fill(params, "foo", 4, block);
+    assert(block.aaa == 56);
+    thrown = false;
+    try {
+        binder.fill(params.get("bar"));
+    }
+    catch (std::runtime_error &) {
+        // "bar" is of "yyy" family, which has no "aaa"
+        thrown = true;
+    }
+    assert(thrown);
+    using namespace std::chrono;
+    constexpr size_t N = 100000;
+    const auto &foo = params.get("foo");
+    size_t sum = 0;
+    auto before = steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        solver_block b;
+        b.aaa = foo.get_int("aaa");
+        b.bbb = foo.get_float("bbb");
+        b.eee = foo.get_string("eee");
+        sum += b.aaa;
+    }
+    auto middle = steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        solver_block b;
+        binder.fill(foo, b);
+        sum += b.aaa;
+    }
+    auto after = steady_clock::now();
+    assert(sum == 2 * 56 * N);
+    double by_name = duration_cast<nanoseconds>(middle - before).count();
+    double bound = duration_cast<nanoseconds>(after - middle).count();
+    std::cout << ">> USECS per struct fill by name: " << by_name / 1000.0 / N << std::endl;
+    std::cout << ">> USECS per struct fill by binder: " << bound / 1000.0 / N << std::endl;
+}
+
+void testsuite_23(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    constexpr size_t N = 1000000;
+    utest_dictionary params;
+    {
+        utest_list big { "family", "xxx" };
+        big.add_value<std::vector<float64_t>>("fvec", std::vector<float64_t>(N, 0.5));
+        params.add("foo", big);
+    }
+    params.set_defaults();
+    params.change_value_onlayer<uint32_t>("foo", "aaa", 99, 3);
+    const auto &foo = params.get("foo");
+    // copies share the values
+    size_t base = heap_bytes_in_use;
+    utest_dictionary copy = params;
+    assert(heap_bytes_in_use - base < 16 * 1024);
+    assert(&copy.get("foo").get_vfloat_ref("fvec") == &foo.get_vfloat_ref("fvec"));
+    // changes are not visible in the source
+    copy.change_value<uint32_t>("foo", "aaa", 11);
+    copy.get("foo").remove_print_converter("aaa");
+    assert(copy.get("foo").get_int("aaa") == 11 && foo.get_int("aaa") == 56);
+    assert(foo.get_value_as_string("aaa") == "56");
+    assert(&copy.get("foo").get_vfloat_ref("fvec") == &foo.get_vfloat_ref("fvec"));
+    // layer views share everything but the overridden keys
+    base = heap_bytes_in_use;
+    heap_bytes_peak = base;
+    auto view = params.get("foo", 3);
+    size_t view_peak = heap_bytes_peak - base;
+    assert(view.get_int("aaa") == 99 && foo.get_int("aaa") == 56);
+    assert(&view.get_vfloat_ref("fvec") == &foo.get_vfloat_ref("fvec"));
+    assert(view_peak < N * sizeof(float64_t) / 100);
+    using namespace std::chrono;
+    constexpr size_t M = 10000;
+    size_t sum = 0;
+    auto before = steady_clock::now();
+    for (size_t i = 0; i < M; i++) {
+        sum += params.get("foo", 3).get_int("aaa");
+    }
+    auto after = steady_clock::now();
+    assert(sum == 99 * M);
+    double duration = duration_cast<microseconds>(after - before).count();
+    std::cout << ">> BYTES peak heap per layer view of a list with " << N << " element vector: " << view_peak << std::endl;
+    std::cout << ">> USECS per layer view of a list with " << N << " element vector: " << duration / M << std::endl;
+}
+
+static bool is_applicable_by_regex(const std::vector<std::string> &m, const std::string &this_family)
+{
+    bool match = true;
+    for (auto &family : m) {
+        if (std::regex_match(family, std::regex("^!.*"))) {
+            if (family == "!" + this_family) {
+                match = false;
+                break;
+            }
+        } else if (family == this_family) {
+            match = true;
+            break;
+        } else {
+            match = false;
+        }
+    }
+    return match;
+}
+
+void testsuite_24(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    const auto &expected_params = utest_params_details::get_expected_params();
+    const auto &symbols = params::symbol_table<utest_params_details>::get();
+    for (auto family : { "xxx", "yyy", "zzz", "other", "" }) {
+        const auto &mask = symbols.applicable(family);
+        for (size_t id = 0; id < expected_params.size(); id++) {
+            assert(mask.test(id) == is_applicable_by_regex(expected_params[id].second.matching_families, family));
+        }
+    }
+    // order-dependent cases of the matching rules
+    assert(!is_applicable_by_regex({ "aaa", "!yyy" }, "xxx"));
+    utest_list yyy { "family", "yyy" };
+    utest_list other { "family", "other" };
+    assert(yyy.is_param_applicable("ccc") && !yyy.is_param_applicable("hhh") && !yyy.is_param_applicable("bbb"));
+    assert(other.is_param_applicable("hhh") && !other.is_param_applicable("ccc") && other.is_param_applicable("aaa"));
+    using namespace std::chrono;
+    constexpr size_t N = 1000;
+    size_t n1 = 0, n2 = 0;
+    auto before = steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        const auto &family = yyy.get_string_ref("family");
+        for (auto &e : expected_params) {
+            n1 += is_applicable_by_regex(e.second.matching_families, family);
+        }
+    }
+    auto middle = steady_clock::now();
+    for (size_t i = 0; i < N; i++) {
+        const auto &mask = yyy.get_applicable_params();
+        for (size_t id = 0; id < expected_params.size(); id++) {
+            n2 += mask.test(id);
+        }
+    }
+    auto after = steady_clock::now();
+    assert(n1 == n2);
+    double by_regex = duration_cast<nanoseconds>(middle - before).count();
+    double by_mask = duration_cast<nanoseconds>(after - middle).count();
+    std::cout << ">> USECS per family filtering of a list by regex: " << by_regex / 1000.0 / N << std::endl;
+    std::cout << ">> USECS per family filtering of a list by mask: " << by_mask / 1000.0 / N << std::endl;
+}
+
+// print_list() output of the lists below, as printed line by line before the tables were rendered in one buffer
+static const char *expected_print_list_output =
+        "|------------------------------------------------------------------|\n"
+        "|         foo                                                      |\n"
+        "|------------------------------------------------------------------|\n"
+        "| family                               |                       xxx |\n"
+        "| aaa                                  |                        56 |\n"
+        "| bbb                                  |                     1.234 |\n"
+        "| eee                                  |                     test2 |\n"
+        "| fff                                  |                      test |\n"
+        "| hhh                                  |                         2 |\n"
+        "| iii                                  |                         5 |\n"
+        "| ivec                                 |               [ 1, 2, 3 ] |\n"
+        "| fvec                                 |               [UNDEFINED] |\n"
+        "| svec                                 |               [UNDEFINED] |\n"
+        "| bvec                                 |               [UNDEFINED] |\n"
+        "|------------------------------------------------------------------|\n"
+        "|------------------------------------------------------------------|\n"
+        "|         bar                                                      |\n"
+        "|------------------------------------------------------------------|\n"
+        "| family                               |                       yyy |\n"
+        "| aaa                                  |               [UNDEFINED] |\n"
+        "| eee                                  |                     test1 |\n"
+        "| eee (lev.1)                          |                     test3 |\n"
+        "| ccc                                  |                     4.567 |\n"
+        "| ddd                                  |                       777 |\n"
+        "| fff                                  |                      test |\n"
+        "| iii                                  |                         5 |\n"
+        "| ivec                                 |               [UNDEFINED] |\n"
+        "| fvec                                 |               [UNDEFINED] |\n"
+        "| svec                                 |               [UNDEFINED] |\n"
+        "| bvec                                 |               [UNDEFINED] |\n"
+        "|------------------------------------------------------------------|\n"
+        "|------------------------------------------------------------------|\n"
+        "|         baz                                                      |\n"
+        "|------------------------------------------------------------------|\n"
+        "| family                               |                       zzz |\n"
+        "| aaa                                  |                        56 |\n"
+        "| bbb                                  |                     1.234 |\n"
+        "| ddd                                  |                       777 |\n"
+        "| hhh                                  |                         2 |\n"
+        "| iii                                  |                         5 |\n"
+        "| ivec                                 |               [UNDEFINED] |\n"
+        "| fvec                                 |               [UNDEFINED] |\n"
+        "| svec                                 |                  [ a, b ] |\n"
+        "| bvec                                 |               [UNDEFINED] |\n"
+        "|------------------------------------------------------------------|\n"
+        "|------------------------------------------------------------------|\n"
+        "|         qux                                                      |\n"
+        "|------------------------------------------------------------------|\n"
+        "| family                               |                       zzz |\n"
+        "| aaa                                  |                        56 |\n"
+        "| aaa (lev.3)                          |                         5 |\n"
+        "| bbb                                  |                     1.234 |\n"
+        "| ddd                                  |                       777 |\n"
+        "| ddd (lev.2)                          |                         1 |\n"
+        "| ddd (lev.7)                          |                         2 |\n"
+        "| hhh                                  |                         2 |\n"
+        "| iii                                  |                         5 |\n"
+        "| ivec                                 |               [UNDEFINED] |\n"
+        "| fvec                                 |               [UNDEFINED] |\n"
+        "| svec                                 |               [UNDEFINED] |\n"
+        "| bvec                                 |               [UNDEFINED] |\n"
+        "|------------------------------------------------------------------|\n";
+
+void testsuite_25(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    {
+        utest_dictionary params;
+        params.add_override("qux", {{"aaa", "5@lev3"}, {"ddd", "1@lev2;2@lev7"}});
+        params.add_override("bar", {{"eee", "test3@lev1"}});
+        params.set_defaults();
+        params.change_value<std::vector<uint32_t>>("foo", "ivec", { 1, 2, 3 });
+        params.change_value<std::vector<std::string>>("baz", "svec", { "a", "b" });
+        std::string printed;
+        utest_params_details::captured_output = &printed;
+        std::stringstream rendered;
+        for (auto &name : { "foo", "bar", "baz", "qux" }) {
+            params.print_list(name, name);
+            params.render_list(rendered, name, name);
+        }
+        utest_params_details::captured_output = nullptr;
+        assert(printed == expected_print_list_output);
+        assert(rendered.str() == expected_print_list_output);
+    }
+    constexpr size_t N = 800;
+    utest_dictionary params;
+    for (size_t i = 0; i < N; i++) {
+        params.add(std::string("list") + std::to_string(i), { "family", "xxx" });
+    }
+    params.set_defaults();
+    using namespace std::chrono;
+    std::string by_lines, buffered, whole;
+    utest_params_details::captured_output = &by_lines;
+    utest_params_details::nflushes = 0;
+    auto t0 = steady_clock::now();
+    for (auto &i : params.m) {
+        utest_params_details::print_list_by_lines(params, i.first);
+    }
+    auto t1 = steady_clock::now();
+    size_t flushes_by_lines = utest_params_details::nflushes;
+    utest_params_details::captured_output = &buffered;
+    utest_params_details::nflushes = 0;
+    auto t2 = steady_clock::now();
+    for (auto &i : params.m) {
+        params.print_list(i.first, i.first);
+    }
+    auto t3 = steady_clock::now();
+    size_t flushes_buffered = utest_params_details::nflushes;
+    utest_params_details::captured_output = &whole;
+    auto t4 = steady_clock::now();
+    std::stringstream ss;
+    for (auto &i : params.m) {
+        params.render_list(ss, i.first, i.first);
+    }
+    utest_params_details::print_stream(ss);
+    auto t5 = steady_clock::now();
+    utest_params_details::captured_output = nullptr;
+    size_t nlines = std::count(by_lines.begin(), by_lines.end(), '\n');
+    assert(nlines > 10000 && flushes_by_lines == nlines && flushes_buffered == params.size());
+    assert(by_lines == buffered && by_lines == whole);
+    std::cout << ">> USECS per " << nlines << "-line table printed line by line: " 
+              << duration_cast<microseconds>(t1 - t0).count() << std::endl;
+    std::cout << ">> USECS per " << nlines << "-line table printed list by list: " 
+              << duration_cast<microseconds>(t3 - t2).count() << std::endl;
+    std::cout << ">> USECS per " << nlines << "-line table rendered at once: " 
+              << duration_cast<microseconds>(t5 - t4).count() << std::endl;
+}
+
 int main(int argc, char **argv)
 {
     testsuite_0(argc, argv);
@@ -268,5 +1121,20 @@ int main(int argc, char **argv)
 	testsuite_8(argc, argv);
 	testsuite_9(argc, argv);
 	testsuite_10(argc, argv);
+	testsuite_11(argc, argv);
+	testsuite_12(argc, argv);
+	testsuite_13(argc, argv);
+	testsuite_14(argc, argv);
+	testsuite_15(argc, argv);
+	testsuite_16(argc, argv);
+	testsuite_17(argc, argv);
+	testsuite_18(argc, argv);
+	testsuite_19(argc, argv);
+	testsuite_20(argc, argv);
+	testsuite_21(argc, argv);
+	testsuite_22(argc, argv);
+	testsuite_23(argc, argv);
+	testsuite_24(argc, argv);
+	testsuite_25(argc, argv);
     return 0;
 }
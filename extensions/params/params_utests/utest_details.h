@@ -23,24 +23,51 @@ struct utest_params_details {
 	using my_list = params::list<utest_params_details>;
 
     static bool use_debug_print_tables;
+    static uint16_t nlayers;
     
     static std::string get_family_key() { return "family"; }
     static std::string get_layer_prefix() { return "lev"; }
-	static uint16_t get_nlayers() { return 100; }
+	static uint16_t get_nlayers() { return nlayers; }
+
+    // when set, the output is collected here instead of std::cout
+    static std::string *captured_output;
+    static size_t nflushes;
 
     static void print_stream(const std::stringstream &ss) {
+        nflushes++;
+        if (captured_output) {
+            *captured_output += ss.str();
+            return;
+        }
         std::cout << ss.str();
     }
 
-    static void print_table(const my_dictionary &params) {
+    // Line by line printing of a list without overrides, as a reference for buffered rendering
+    static void print_list_by_lines(const my_dictionary &params, const std::string &name) {
+        const auto &l = params.get(name);
+	    my_list::print_line_delimiter();
+    	my_list::print_header(name);
 	    my_list::print_line_delimiter();
-    	my_list::print_header("Unit test for params");
+        const auto &applicable = l.get_applicable_params();
+        const auto &expected_params = get_expected_params();
+        for (size_t id = 0; id < expected_params.size(); id++) {
+            if (applicable.test(id))
+                l.print_line(expected_params[id].first);
+        }
+	    my_list::print_line_delimiter();
+    }
+
+    static void print_table(const my_dictionary &params) {
+        std::stringstream ss;
+	    my_list::render_line_delimiter(ss);
+    	my_list::render_header(ss, "Unit test for params");
         auto size = params.size();
         for (size_t i = 0; i < size; i++) {
             auto &l = params.get(i);
             if (!std::regex_search(l, std::regex("_override")))
-                params.print_list(l, l);
+                params.render_list(ss, l, l);
         }
+        print_stream(ss);
     }
 
 
@@ -112,3 +139,53 @@ struct utest_params_details {
         list.add_print_converter("aaa", custom_print<utest_params_details>);
 	}
 };
+
+//        identifier, name,     type, changeable, families,         {min,max},   allowed values
+#define UTEST_PARAMS(X) \
+        X(family,     "family", S,    false,      (),               (),          ()) \
+        X(aaa,        "aaa",    I,    true,       (),               (),          ()) \
+        X(bbb,        "bbb",    F,    true,       ("xxx", "zzz"),   (),          ()) \
+        X(eee,        "eee",    S,    true,       ("xxx", "yyy"),   (),          ("test1", "test2", "test3")) \
+        X(ccc,        "ccc",    F,    false,      ("yyy"),          (),          ()) \
+        X(ddd,        "ddd",    I,    true,       ("yyy", "zzz"),   (),          ()) \
+        X(fff,        "fff",    S,    false,      ("yyy", "xxx"),   (),          ()) \
+        X(hhh,        "hhh",    I,    false,      ("!yyy"),         ("1", "3"),  ()) \
+        X(iii,        "iii",    I,    false,      (),               (),          ("1", "2", "5")) \
+        X(ivec,       "ivec",   IV,   true,       (),               (),          ()) \
+        X(fvec,       "fvec",   FV,   true,       (),               (),          ()) \
+        X(svec,       "svec",   SV,   true,       (),               (),          ()) \
+        X(bvec,       "bvec",   BV,   true,       (),               (),          ())
+
+PARAMS_SCHEMA(utest_schema, UTEST_PARAMS)
+
+// The same parameters declared through the compile-time schema, for the typed accessors
+struct utest_schema_details : utest_params_details {
+	using my_dictionary = params::dictionary<utest_schema_details>;
+	using my_list = params::list<utest_schema_details>;
+
+    using schema = utest_schema;
+	static const params::expected_params_t &get_expected_params() {
+		return schema::get_expected_params();
+    }
+
+	static void set_dictionary_defaults(my_dictionary &params) {
+		for (auto &name_family : { std::make_pair("foo", "xxx"), std::make_pair("bar", "yyy"),
+								   std::make_pair("baz", "zzz"), std::make_pair("qux", "zzz") }) {
+			if (!params.find(name_family.first)) {
+				params.add(name_family.first, my_list { "family", name_family.second });
+			}
+		}
+	}
+
+	static void set_family_defaults(my_list &list, const std::string &family, 
+									const std::string &list_name) {
+		// the parameters are the same and in the same order, so the defaults are taken over
+		utest_params_details::my_list defaults;
+		utest_params_details::set_family_defaults(defaults, family, list_name);
+		for (const auto &i : defaults.get_raw_list()) {
+			if (!list.is_value_set(i.first))
+				list.set_unsafe(i.first, i.second);
+		}
+        list.add_print_converter("aaa", custom_print<utest_schema_details>);
+	}
+};
@@ -18,12 +18,83 @@ template<> value::type_t value::get_type<std::vector<bool>>() const { return val
 template<> value::type_t value::get_type<std::vector<std::string>>() const { return value::type_t::SV; }
 
 
+void value::reset() {
+    switch (type) {
+        case S: destroy(s); break;
+        case IV: destroy(iv); break;
+        case FV: destroy(fv); break;
+        case BV: destroy(bv); break;
+        case SV: destroy(sv); break;
+        default: break;
+    }
+    type = NUL;
+}
+
+void value::copy_from(const value &other) {
+    switch (other.type) {
+        case I: i = other.i; break;
+        case F: f = other.f; break;
+        case B: b = other.b; break;
+        case S: new (&s) std::string(other.s); break;
+        case IV: new (&iv) std::vector<uint32_t>(other.iv); break;
+        case FV: new (&fv) std::vector<float64_t>(other.fv); break;
+        case BV: new (&bv) std::vector<bool>(other.bv); break;
+        case SV: new (&sv) std::vector<std::string>(other.sv); break;
+        case NUL: break;
+    }
+    type = other.type;
+}
+
+void value::move_from(value &other) {
+    switch (other.type) {
+        case I: i = other.i; break;
+        case F: f = other.f; break;
+        case B: b = other.b; break;
+        case S: new (&s) std::string(std::move(other.s)); break;
+        case IV: new (&iv) std::vector<uint32_t>(std::move(other.iv)); break;
+        case FV: new (&fv) std::vector<float64_t>(std::move(other.fv)); break;
+        case BV: new (&bv) std::vector<bool>(std::move(other.bv)); break;
+        case SV: new (&sv) std::vector<std::string>(std::move(other.sv)); break;
+        case NUL: break;
+    }
+    type = other.type;
+}
+
+value::value(const value &other) { copy_from(other); }
+value::value(value &&other) { move_from(other); }
+
+value &value::operator=(const value &other) {
+    if (this != &other) {
+        reset();
+        copy_from(other);
+    }
+    return *this;
+}
+
+value &value::operator=(value &&other) {
+    if (this != &other) {
+        reset();
+        move_from(other);
+    }
+    return *this;
+}
+
+template<> void value::set(uint32_t val) { reset(); i = val; type = I; }
+template<> void value::set(float64_t val) { reset(); f = val; type = F; }
+template<> void value::set(bool val) { reset(); b = val; type = B; }
+template<> void value::set(std::string val) { reset(); new (&s) std::string(std::move(val)); type = S; }
+template<> void value::set(std::vector<uint32_t> val) { reset(); new (&iv) std::vector<uint32_t>(std::move(val)); type = IV; }
+template<> void value::set(std::vector<float64_t> val) { reset(); new (&fv) std::vector<float64_t>(std::move(val)); type = FV; }
+template<> void value::set(std::vector<bool> val) { reset(); new (&bv) std::vector<bool>(std::move(val)); type = BV; }
+template<> void value::set(std::vector<std::string> val) { reset(); new (&sv) std::vector<std::string>(std::move(val)); type = SV; }
+template<> void value::set(value other) { *this = std::move(other); }
+
 template<> void value::autoconv<value::I>() {
     switch (type) {
         case I: break;
-        case F: i = (uint32_t)f; type = I; break;
+        case F: set<uint32_t>((uint32_t)f); break;
         case S: throw std::runtime_error(std::string("params: autoconv<I>: autoconvertion of a parameter from string requested"));
-        case B: i = (b ? 1 : 0); break;
+        case B: set<uint32_t>(b ? 1 : 0); break;
         case NUL: break;
         case IV: throw std::runtime_error(std::string("params: autoconv<I>: autoconvertion of a parameter from vector"));
         case FV: throw std::runtime_error(std::string("params: autoconv<I>: autoconvertion of a parameter from vector"));
@@ -35,10 +106,10 @@ template<> void value::autoconv<value::I>() {
 
 template<> void value::autoconv<value::F>() {
     switch (type) {
-        case I: f = (float64_t)i; type = F; break;
+        case I: set<float64_t>((float64_t)i); break;
         case F: break;
         case S: throw std::runtime_error(std::string("params: autoconv<F>: autoconvertion of a parameter from string requested"));
-        case B: f = (b ? 1.0f : 0.0f); break;
+        case B: set<float64_t>(b ? 1.0f : 0.0f); break;
         case NUL: break;
         case IV: throw std::runtime_error(std::string("params: autoconv<I>: autoconvertion of a parameter from vector"));
         case FV: throw std::runtime_error(std::string("params: autoconv<I>: autoconvertion of a parameter from vector"));
@@ -70,48 +141,39 @@ void vec2str(std::string &str, const std::vector<T> &v, std::function<std::strin
 }
 
 template<> void value::autoconv<value::S>() {
+    std::string str;
     switch (type) {
-        case I: s = std::to_string(i); type = S; break; 
-        case F: s = float_to_string(f); type = S; break;
+        case I: set<std::string>(std::to_string(i)); break; 
+        case F: set<std::string>(float_to_string(f)); break;
         case S: break;
-        case B: s = (b ? "true" : "false"); type = S; break;
+        case B: set<std::string>(b ? "true" : "false"); break;
         case NUL: break;
-        case IV: vec2str<uint32_t>(s, iv, [](uint32_t x) -> std::string {return std::to_string(x);}); type = S; break;
-        case FV: vec2str<float64_t>(s, fv, [](float64_t x) -> std::string {return float_to_string(x);}); type = S; break;
-        case SV: vec2str<std::string>(s, sv, [](std::string x) -> std::string {return x;}); type = S; break;
-        case BV: vec2str<bool>(s, bv, [](bool x) -> std::string {return (x ? "true" : "false");}); type = S; break;
+        case IV: vec2str<uint32_t>(str, iv, [](uint32_t x) -> std::string {return std::to_string(x);}); set<std::string>(str); break;
+        case FV: vec2str<float64_t>(str, fv, [](float64_t x) -> std::string {return float_to_string(x);}); set<std::string>(str); break;
+        case SV: vec2str<std::string>(str, sv, [](std::string x) -> std::string {return x;}); set<std::string>(str); break;
+        case BV: vec2str<bool>(str, bv, [](bool x) -> std::string {return (x ? "true" : "false");}); set<std::string>(str); break;
     }
 }
 
-template<> void value::set(uint32_t val) { i = val; type = I; }
-template<> void value::set(float64_t val) { f = val; type = F; }
-template<> void value::set(bool val) { b = val; type = B; }
-template<> void value::set(std::string val) { s = val; type = S; }
-template<> void value::set(std::vector<uint32_t> val) { iv = val; type = IV; }
-template<> void value::set(std::vector<float64_t> val) { fv = val; type = FV; }
-template<> void value::set(std::vector<bool> val) { bv = val; type = BV; }
-template<> void value::set(std::vector<std::string> val) { sv = val; type = SV; }
-template<> void value::set(value other) { *this = other; }
-
 // scalars
-template<> uint32_t &value::get<uint32_t>() { assert(type == I); return i; }
-template<> float64_t &value::get<float64_t>() { assert(type == F); return f; }
-template<> bool &value::get<bool>() { assert(type == B); return b; }
-template<> std::string &value::get<std::string>() { assert(type == S); return s; }
-template<> const uint32_t &value::get<uint32_t>() const { assert(type == I); return i; }
-template<> const float64_t &value::get<float64_t>() const { assert(type == F); return f; }
-template<> const bool &value::get<bool>() const { assert(type == B); return b; }
-template<> const std::string &value::get<std::string>() const { assert(type == S); return s; }
+template<> uint32_t &value::get<uint32_t>() { check_type(I); return i; }
+template<> float64_t &value::get<float64_t>() { check_type(F); return f; }
+template<> bool &value::get<bool>() { check_type(B); return b; }
+template<> std::string &value::get<std::string>() { check_type(S); return s; }
+template<> const uint32_t &value::get<uint32_t>() const { check_type(I); return i; }
+template<> const float64_t &value::get<float64_t>() const { check_type(F); return f; }
+template<> const bool &value::get<bool>() const { check_type(B); return b; }
+template<> const std::string &value::get<std::string>() const { check_type(S); return s; }
 
 //vectors
-template<> std::vector<uint32_t> &value::get<std::vector<uint32_t>>() { assert(type == IV); return iv; }
-template<> std::vector<float64_t> &value::get<std::vector<float64_t>>() { assert(type == FV); return fv; }
-template<> std::vector<bool> &value::get<std::vector<bool>>() { assert(type == BV); return bv; }
-template<> std::vector<std::string> &value::get<std::vector<std::string>>() { assert(type == SV); return sv; }
-template<> const std::vector<uint32_t> &value::get<std::vector<uint32_t>>() const { assert(type == IV); return iv; }
-template<> const std::vector<float64_t> &value::get<std::vector<float64_t>>() const { assert(type == FV); return fv; }
-template<> const std::vector<bool> &value::get<std::vector<bool>>() const { assert(type == BV); return bv; }
-template<> const std::vector<std::string> &value::get<std::vector<std::string>>() const { assert(type == SV); return sv; }
+template<> std::vector<uint32_t> &value::get<std::vector<uint32_t>>() { check_type(IV); return iv; }
+template<> std::vector<float64_t> &value::get<std::vector<float64_t>>() { check_type(FV); return fv; }
+template<> std::vector<bool> &value::get<std::vector<bool>>() { check_type(BV); return bv; }
+template<> std::vector<std::string> &value::get<std::vector<std::string>>() { check_type(SV); return sv; }
+template<> const std::vector<uint32_t> &value::get<std::vector<uint32_t>>() const { check_type(IV); return iv; }
+template<> const std::vector<float64_t> &value::get<std::vector<float64_t>>() const { check_type(FV); return fv; }
+template<> const std::vector<bool> &value::get<std::vector<bool>>() const { check_type(BV); return bv; }
+template<> const std::vector<std::string> &value::get<std::vector<std::string>>() const { check_type(SV); return sv; }
 
 template<> uint32_t value::get_max_possible_value() { return I_MAX; }
 template<> float64_t value::get_max_possible_value() { return F_MAX; }
@@ -182,36 +244,36 @@ void value::parse_and_set(value::type_t t, const std::vector<std::string> &vec)
     }
     if (t == value::IV) {
         value v;
-        iv.resize(0);
+        std::vector<uint32_t> r;
+        r.reserve(vec.size());
         for (const auto &s : vec) {
             v.parse_and_set(value::I, s);
-            iv.push_back(v.i);
+            r.push_back(v.i);
         }
+        set(std::move(r));
     } else if (t == value::FV) {
         value v;
-        fv.resize(0);
+        std::vector<float64_t> r;
+        r.reserve(vec.size());
         for (const auto &s : vec) {
             v.parse_and_set(value::F, s);
-            fv.push_back(v.f);
+            r.push_back(v.f);
         }
+        set(std::move(r));
     } else if (t == value::SV) {
-        value v;
-        sv.resize(0);
-        for (const auto &str : vec) {
-            v.parse_and_set(value::S, str);
-            sv.push_back(v.s);
-        }
+        set(vec);
     } else if (t == value::BV) {
         value v;
-        bv.resize(0);
+        std::vector<bool> r;
+        r.reserve(vec.size());
         for (const auto &s : vec) {
             v.parse_and_set(value::B, s);
-            bv.push_back(v.b);
+            r.push_back(v.b);
         }
+        set(std::move(r));
     } else {
         assert(0 && "unknown type");
     }
-    type = t;
 }
 
 std::string value::as_string() const { 
@@ -102,19 +102,112 @@ struct yaml_read_assistant {
         return node.IsMap();
     }
     bool get_all_lists(const std::string &dictionary_entry, params::dictionary<T> &dict) {
+        // NOTE: a single walk over the dictionary subtree: each scalar is parsed 
+        // directly into the typed value of the list entry
         if (dictionary_entry.back() != '/') {
             throw std::runtime_error("yaml_read_assistant::get_all_lists: yaml dictionary entry name must end with '/'");
         }
-        if (!dictionary_exists(dictionary_entry))
+        YAML::Node node = stream;
+        auto node_names = helpers::str_split(dictionary_entry, '/');
+        for (const auto &name : node_names) {
+            if (name.empty())
+                break;
+            if (!node.IsMap()) {
+                throw std::runtime_error("yaml_read_assistant::get_all_lists: entry is not a map");
+            }
+            YAML::Node next = node[name];
+            if (!next) {
+                return false;
+            }
+            node.reset(next);
+        }
+        if (!node.IsMap()) 
             return false;
-        std::vector<std::string> keys;
-        get_map_keys(dictionary_entry, keys);
-        for (const auto &key : keys) {
-            auto list_entry = dictionary_entry + key;
-            get_list(list_entry, dict);
+        for (auto it = node.begin(); it != node.end(); ++it) {
+            load_list(it->first.Scalar(), it->second, dict);
         }
         return true;
     }
+    protected:
+    void load_list(const std::string &list_name, const YAML::Node &node, params::dictionary<T> &dict) {
+        const auto &expected_params = T::get_expected_params();
+        params::list<T> list;
+        if ("-" == T::get_family_key()) {
+            list.parse_and_set_value("-", "-");
+        }
+        if (!node.IsMap()) {
+            throw std::runtime_error("yaml_read_assistant::get_all_lists: entry is not a map: " + list_name);
+        }
+        for (auto it = node.begin(); it != node.end(); ++it) {
+            const std::string &k = it->first.Scalar();
+            auto id = params::list<T>::get_id(k);
+            if (id == params::symbol_table<T>::npos) {
+                throw std::runtime_error(std::string("yaml_read_assistant::get_all_lists: unknown parameter: ") + k);
+            }
+            auto t = expected_params[id].second.type;
+            value v;
+            if (it->second.IsSequence()) {
+                parse_sequence(t, k, it->second, v);
+            } else if (it->second.IsScalar()) {
+                v.parse_and_set(t, it->second.Scalar());
+            } else {
+                throw std::runtime_error("yaml_read_assistant::get_all_lists: wrong map structure: it may contain only scalars or sequences");
+            }
+            list.set(k, v);
+        }
+        dict.add(list_name, list);
+    }
+    static void parse_sequence(value::type_t t, const std::string &k, const YAML::Node &seq, value &v) {
+        value elem;
+        for (auto it = seq.begin(); it != seq.end(); ++it) {
+            if (!it->IsScalar()) {
+                throw std::runtime_error(std::string("yaml_read_assistant::get_all_lists: sequence of scalars is expected: ") + k);
+            }
+        }
+        switch (t) {
+            case value::IV: {
+                std::vector<uint32_t> r;
+                r.reserve(seq.size());
+                for (auto it = seq.begin(); it != seq.end(); ++it) {
+                    elem.parse_and_set(value::I, it->Scalar());
+                    r.push_back(elem.i);
+                }
+                v.set(std::move(r));
+                break;
+            }
+            case value::FV: {
+                std::vector<float64_t> r;
+                r.reserve(seq.size());
+                for (auto it = seq.begin(); it != seq.end(); ++it) {
+                    elem.parse_and_set(value::F, it->Scalar());
+                    r.push_back(elem.f);
+                }
+                v.set(std::move(r));
+                break;
+            }
+            case value::BV: {
+                std::vector<bool> r;
+                r.reserve(seq.size());
+                for (auto it = seq.begin(); it != seq.end(); ++it) {
+                    elem.parse_and_set(value::B, it->Scalar());
+                    r.push_back(elem.b);
+                }
+                v.set(std::move(r));
+                break;
+            }
+            case value::SV: {
+                std::vector<std::string> r;
+                r.reserve(seq.size());
+                for (auto it = seq.begin(); it != seq.end(); ++it) {
+                    r.push_back(it->Scalar());
+                }
+                v.set(std::move(r));
+                break;
+            }
+            default:
+                throw std::runtime_error(std::string("yaml_read_assistant::get_all_lists: parameter is not a vector: ") + k);
+        }
+    }
 };
 
 }
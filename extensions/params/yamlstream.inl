@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2020-2024 Alexey V. Medvedev
+ * This code is licensed under 3-Clause BSD License.
+ * See license.txt file for details.
+ */
+#pragma once
+
+#include <yaml-cpp/eventhandler.h>
+#include <yaml-cpp/parser.h>
+
+namespace params {
+
+// Event-driven counterpart of yaml_read_assistant::get_all_lists(): the YAML stream is
+// parsed without building a YAML::Node tree, all subtrees out of the dictionary entry
+// are skipped and lists are filled in directly from the scalar events.
+template <typename T>
+struct yaml_stream_reader {
+    bool get_all_lists(std::istream &in, const std::string &dictionary_entry, params::dictionary<T> &dict) {
+        if (dictionary_entry.empty() || dictionary_entry.back() != '/') {
+            throw std::runtime_error("yaml_stream_reader::get_all_lists: yaml dictionary entry name must end with '/'");
+        }
+        handler h(dictionary_entry, dict);
+        YAML::Parser parser(in);
+        try {
+            parser.HandleNextDocument(h);
+        }
+        catch (const typename handler::done_t &) {
+        }
+        return h.found;
+    }
+
+    protected:
+    struct handler : public YAML::EventHandler {
+        struct done_t {};
+        enum role_t { ROUTE, DICT, LIST, SEQ };
+        struct frame {
+            role_t role;
+            bool is_map;
+            bool expect_key;
+            size_t depth;
+            std::string key;
+        };
+        std::vector<std::string> path;
+        params::dictionary<T> &dict;
+        bool found = false;
+        std::vector<frame> stack;
+        size_t skip = 0;
+        params::list<T> list;
+        std::string list_name;
+        value::type_t seq_type = value::NUL;
+        value seq;
+        std::vector<uint32_t> iv;
+        std::vector<float64_t> fv;
+        std::vector<bool> bv;
+        std::vector<std::string> sv;
+
+        handler(const std::string &dictionary_entry, params::dictionary<T> &dict_) : dict(dict_) {
+            for (const auto &name : helpers::str_split(dictionary_entry, '/')) {
+                if (name.empty())
+                    break;
+                path.push_back(name);
+            }
+        }
+
+        // Decides what the next node is: a key, a value to be processed or a subtree to be skipped.
+        // Returns false if the node must be ignored; 'role' is the role of a container node.
+        bool on_node(bool is_container, bool is_map, role_t &role) {
+            if (skip) {
+                if (is_container)
+                    skip++;
+                return false;
+            }
+            if (stack.empty()) {
+                if (!is_map) {
+                    skip += is_container;
+                    return false;
+                }
+                role = (path.empty() ? DICT : ROUTE);
+                found = found || path.empty();
+                return true;
+            }
+            frame &parent = stack.back();
+            if (parent.is_map && parent.expect_key) {
+                parent.expect_key = false;
+                parent.key.clear();
+                skip += is_container;
+                return false;
+            }
+            if (parent.is_map)
+                parent.expect_key = true;
+            switch (parent.role) {
+                case ROUTE:
+                    if (parent.key != path[parent.depth]) {
+                        skip += is_container;
+                        return false;
+                    }
+                    if (!is_map) {
+                        if (parent.depth + 1 < path.size())
+                            throw std::runtime_error("yaml_stream_reader::get_all_lists: entry is not a map");
+                        skip += is_container;
+                        return false;
+                    }
+                    role = (parent.depth + 1 == path.size() ? DICT : ROUTE);
+                    found = found || (role == DICT);
+                    return true;
+                case DICT:
+                    if (!is_map) {
+                        throw std::runtime_error("yaml_stream_reader::get_all_lists: entry is not a map: " + parent.key);
+                    }
+                    role = LIST;
+                    return true;
+                case LIST:
+                    if (is_map) {
+                        throw std::runtime_error("yaml_stream_reader::get_all_lists: wrong map structure: it may contain only scalars or sequences");
+                    }
+                    role = SEQ;
+                    return true;
+                case SEQ:
+                    if (is_container) {
+                        throw std::runtime_error(std::string("yaml_stream_reader::get_all_lists: sequence of scalars is expected: ") +
+                                                 stack[stack.size() - 2].key);
+                    }
+                    return true;
+            }
+            return false;
+        }
+
+        void push(role_t role, bool is_map) {
+            size_t depth = (stack.empty() ? 0 : stack.back().depth + (stack.back().role == ROUTE ? 1 : 0));
+            stack.push_back(frame { role, is_map, is_map, depth, "" });
+        }
+
+        value::type_t get_param_type(const std::string &key) {
+            const auto &expected_params = T::get_expected_params();
+            auto id = symbol_table<T>::get().find(key);
+            if (id == symbol_table<T>::npos) {
+                throw std::runtime_error(std::string("yaml_stream_reader::get_all_lists: unknown parameter: ") + key);
+            }
+            return expected_params[id].second.type;
+        }
+
+        virtual void OnDocumentStart(const YAML::Mark &) {}
+        virtual void OnDocumentEnd() {}
+
+        virtual void OnNull(const YAML::Mark &, YAML::anchor_t) {
+            role_t role;
+            if (!on_node(false, false, role))
+                return;
+            throw std::runtime_error("yaml_stream_reader::get_all_lists: wrong map structure: it may contain only scalars or sequences");
+        }
+
+        virtual void OnAlias(const YAML::Mark &, YAML::anchor_t) {
+            role_t role;
+            if (!on_node(false, false, role))
+                return;
+            throw std::runtime_error("yaml_stream_reader::get_all_lists: aliases are not supported in dictionary entry");
+        }
+
+        virtual void OnScalar(const YAML::Mark &, const std::string &, YAML::anchor_t, const std::string &v) {
+            bool is_key = !skip && !stack.empty() && stack.back().is_map && stack.back().expect_key;
+            if (is_key) {
+                stack.back().key = v;
+                stack.back().expect_key = false;
+                return;
+            }
+            role_t role;
+            if (!on_node(false, false, role))
+                return;
+            if (stack.back().role == SEQ) {
+                value elem;
+                switch (seq_type) {
+                    case value::IV: elem.parse_and_set(value::I, v); iv.push_back(elem.i); break;
+                    case value::FV: elem.parse_and_set(value::F, v); fv.push_back(elem.f); break;
+                    case value::BV: elem.parse_and_set(value::B, v); bv.push_back(elem.b); break;
+                    case value::SV: sv.push_back(v); break;
+                    default: break;
+                }
+                return;
+            }
+            auto &key = stack.back().key;
+            value p;
+            p.parse_and_set(get_param_type(key), v);
+            list.set(key, p);
+        }
+
+        virtual void OnSequenceStart(const YAML::Mark &, const std::string &, YAML::anchor_t, YAML::EmitterStyle::value) {
+            role_t role;
+            if (!on_node(true, false, role))
+                return;
+            auto &key = stack.back().key;
+            seq_type = get_param_type(key);
+            if (seq_type != value::IV && seq_type != value::FV && seq_type != value::SV && seq_type != value::BV) {
+                throw std::runtime_error(std::string("yaml_stream_reader::get_all_lists: parameter is not a vector: ") + key);
+            }
+            iv.clear();
+            fv.clear();
+            bv.clear();
+            sv.clear();
+            push(role, false);
+        }
+
+        virtual void OnSequenceEnd() {
+            if (skip) {
+                skip--;
+                return;
+            }
+            stack.pop_back();
+            switch (seq_type) {
+                case value::IV: seq.set(std::move(iv)); break;
+                case value::FV: seq.set(std::move(fv)); break;
+                case value::BV: seq.set(std::move(bv)); break;
+                case value::SV: seq.set(std::move(sv)); break;
+                default: break;
+            }
+            list.set(stack.back().key, seq);
+        }
+
+        virtual void OnMapStart(const YAML::Mark &, const std::string &, YAML::anchor_t, YAML::EmitterStyle::value) {
+            role_t role;
+            if (!on_node(true, true, role))
+                return;
+            if (role == LIST) {
+                list_name = stack.back().key;
+                list = params::list<T>();
+                if ("-" == T::get_family_key()) {
+                    list.parse_and_set_value("-", "-");
+                }
+            }
+            push(role, true);
+        }
+
+        virtual void OnMapEnd() {
+            if (skip) {
+                skip--;
+                return;
+            }
+            role_t role = stack.back().role;
+            stack.pop_back();
+            if (role == LIST) {
+                dict.add(list_name, list);
+            } else if (role == DICT) {
+                // nothing else is needed from the stream
+                throw done_t();
+            }
+        }
+    };
+};
+
+}